@@ -0,0 +1,371 @@
+/*
+  ==============================================================================
+
+    FifoStressTest.cpp
+
+  ==============================================================================
+*/
+
+#include "FifoStressTest.h"
+
+#include "../../Source/PluginProcessor.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+namespace FifoStressTest
+{
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr double sampleRate = 48000.0;
+
+    // The producers write a ramp (sample n = n & valueMask, exact as a float), which the consumers check:
+    static constexpr juce::int64 valueMask = 0xfffff;
+
+    static double getPercentile(const std::vector<double>& sorted, double fraction)
+    {
+        if (sorted.empty())
+            return 0.0;
+
+        return sorted[juce::jmin(sorted.size() - 1, (size_t) (fraction * (double) sorted.size()))];
+    }
+
+    static void fillInLatencies(Result& result, std::vector<double>& latencies)
+    {
+        std::sort(latencies.begin(), latencies.end());
+
+        result.p50 = getPercentile(latencies, 0.5);
+        result.p99 = getPercentile(latencies, 0.99);
+        result.p999 = getPercentile(latencies, 0.999);
+        result.worst = latencies.empty() ? 0.0 : latencies.back();
+    }
+
+    static double microsecondsSince(juce::int64 ticks)
+    {
+        return juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - ticks) * 1.0e6;
+    }
+
+    // Sleeps until 'samplesSinceStart' worth of audio has played since 'start':
+    static void waitForRealtime(Clock::time_point start, juce::int64 samplesSinceStart)
+    {
+        std::this_thread::sleep_until(start + std::chrono::duration<double>((double) samplesSinceStart / sampleRate));
+    }
+
+    // Until the next drain, for a consumer running at 'hz' (flat out, it only yields):
+    static void waitForNextDrain(Clock::time_point& nextDrain, double hz)
+    {
+        if (hz <= 0.0)
+        {
+            std::this_thread::yield();
+            return;
+        }
+
+        nextDrain += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / hz));
+        std::this_thread::sleep_until(nextDrain);
+    }
+
+    //==============================================================================
+    Result runSampleFifo(const Scenario& scenario, double seconds)
+    {
+        jassert(! scenario.fifoSizes.empty());
+
+        SingleChannelSampleFifo<juce::AudioBuffer<float>> fifo(Channel::Left);
+        size_t sizeIndex = 0;
+        fifo.prepare(scenario.fifoSizes[sizeIndex]);
+
+        std::atomic<bool> stopProducer { false }, stopConsumer { false }, pauseRequested { false };
+        juce::WaitableEvent paused, resumed;
+
+        // Only touched by the controller (this thread) while the producer is paused or finished:
+        juce::int64 samplesFed = 0;
+
+        // A buffer is pushed when the sample after its last arrives, so a stream of n samples attempts this many:
+        auto getNumPushesAttempted = [](juce::int64 numSamples, int bufferSize)
+        {
+            return numSamples > 0 ? (numSamples - 1) / bufferSize : 0;
+        };
+
+        std::thread producer([&]
+        {
+            juce::AudioBuffer<float> block(2, scenario.maxBlockSize);
+            juce::Random random(0x5eed);
+
+            auto start = Clock::now();
+            juce::int64 samplesSinceStart = 0;
+
+            while (! stopProducer.load())
+            {
+                // A host stops calling processBlock before it re-prepares:
+                if (pauseRequested.load())
+                {
+                    paused.signal();
+                    resumed.wait();
+
+                    start = Clock::now();
+                    samplesSinceStart = 0;
+                    continue;
+                }
+
+                const auto numSamples = random.nextInt(juce::Range<int>(scenario.minBlockSize, scenario.maxBlockSize + 1));
+                block.setSize(2, numSamples, false, false, true);
+
+                for (int i = 0; i < numSamples; ++i)
+                {
+                    const auto value = (float) ((samplesFed + i) & valueMask);
+                    block.setSample(0, i, value);
+                    block.setSample(1, i, value);
+                }
+
+                fifo.update(block);
+                samplesFed += numSamples;
+
+                if (scenario.realtimeProducer)
+                    waitForRealtime(start, samplesSinceStart += numSamples);
+            }
+        });
+
+        Result result;
+        std::vector<double> latencies;
+        latencies.reserve(1 << 20);
+
+        std::thread consumer([&]
+        {
+            juce::AudioBuffer<float> buffer;
+            FrameStamp stamp;
+
+            // Every sample must be where the ramp puts it, and the last one must match the stamp:
+            auto isIntact = [&]
+            {
+                const auto numSamples = buffer.getNumSamples();
+
+                if (numSamples == 0 || stamp.samplePosition < numSamples - 1)
+                    return false;
+
+                for (int i = 0; i < numSamples; ++i)
+                    if (buffer.getSample(0, i) != (float) ((stamp.samplePosition - (numSamples - 1 - i)) & valueMask))
+                        return false;
+
+                return true;
+            };
+
+            auto drain = [&]
+            {
+                while (fifo.getAudioBuffer(buffer, stamp))
+                {
+                    latencies.push_back(microsecondsSince(stamp.captureTicks));
+                    ++result.numPulled;
+
+                    if (! isIntact())
+                        ++result.numCorrupt;
+                }
+            };
+
+            auto nextDrain = Clock::now();
+
+            while (! stopConsumer.load())
+            {
+                drain();
+                waitForNextDrain(nextDrain, scenario.consumerHz);
+            }
+
+            // (everything the producer managed to push)
+            drain();
+        });
+
+        juce::int64 numPushesAttempted = 0;
+
+        const auto startMs = juce::Time::getMillisecondCounterHiRes();
+        const auto prepareIntervalMs = scenario.preparesPerSecond > 0.0 ? 1000.0 / scenario.preparesPerSecond : 0.0;
+        auto nextPrepareMs = startMs + prepareIntervalMs;
+
+        while (juce::Time::getMillisecondCounterHiRes() < startMs + seconds * 1000.0)
+        {
+            if (prepareIntervalMs > 0.0 && juce::Time::getMillisecondCounterHiRes() >= nextPrepareMs)
+            {
+                pauseRequested.store(true);
+                paused.wait();
+
+                numPushesAttempted += getNumPushesAttempted(samplesFed, fifo.getSize());
+                samplesFed = 0;
+
+                // ...while the consumer carries on:
+                sizeIndex = (sizeIndex + 1) % scenario.fifoSizes.size();
+                fifo.prepare(scenario.fifoSizes[sizeIndex]);
+                ++result.numPrepares;
+
+                pauseRequested.store(false);
+                resumed.signal();
+
+                nextPrepareMs += prepareIntervalMs;
+            }
+
+            juce::Thread::sleep(1);
+        }
+
+        stopProducer.store(true);
+        producer.join();
+        numPushesAttempted += getNumPushesAttempted(samplesFed, fifo.getSize());
+
+        stopConsumer.store(true);
+        consumer.join();
+
+        result.buffersPerSecond = (double) result.numPulled / seconds;
+        result.dropRate = numPushesAttempted > 0 ? juce::jmax(0.0, 1.0 - (double) result.numPulled / (double) numPushesAttempted) : 0.0;
+        fillInLatencies(result, latencies);
+
+        return result;
+    }
+
+    //==============================================================================
+    Result runVectorFifo(const Scenario& scenario, double seconds)
+    {
+        jassert(! scenario.fifoSizes.empty());
+
+        const auto vectorSize = (size_t) scenario.fifoSizes.front();
+
+        Fifo<std::vector<float>> fifo;
+        fifo.prepare(vectorSize);
+
+        // Push times, by sequence number. There's more room than the fifo holds, so the producer never
+        // overwrites an entry the consumer has yet to read:
+        std::array<juce::int64, 64> pushTicks {};
+
+        std::atomic<bool> stopProducer { false }, stopConsumer { false };
+        juce::int64 numPushesAttempted = 0, numPushesFailed = 0;
+
+        std::thread producer([&]
+        {
+            std::vector<float> element(vectorSize);
+            juce::Random random(0x5eed);
+            juce::int64 sequence = 0;
+
+            const auto start = Clock::now();
+            juce::int64 samplesSinceStart = 0;
+
+            std::fill(element.begin(), element.end(), 0.f);
+
+            while (! stopProducer.load())
+            {
+                pushTicks[(size_t) (sequence % (juce::int64) pushTicks.size())] = juce::Time::getHighResolutionTicks();
+                ++numPushesAttempted;
+
+                // (one push per block of audio, as the analyser does)
+                if (fifo.push(element))
+                    std::fill(element.begin(), element.end(), (float) (++sequence & valueMask));
+                else
+                    ++numPushesFailed;
+
+                if (scenario.realtimeProducer)
+                    waitForRealtime(start, samplesSinceStart += random.nextInt(juce::Range<int>(scenario.minBlockSize, scenario.maxBlockSize + 1)));
+            }
+        });
+
+        Result result;
+        std::vector<double> latencies;
+        latencies.reserve(1 << 20);
+
+        std::thread consumer([&]
+        {
+            std::vector<float> element;
+            juce::int64 expectedSequence = 0;
+
+            auto drain = [&]
+            {
+                while (fifo.pull(element))
+                {
+                    latencies.push_back(microsecondsSince(pushTicks[(size_t) (expectedSequence % (juce::int64) pushTicks.size())]));
+                    ++result.numPulled;
+
+                    // In order, and not torn:
+                    const auto expectedValue = (float) (expectedSequence & valueMask);
+
+                    if (element.size() != vectorSize
+                        || std::any_of(element.begin(), element.end(), [expectedValue](float v) { return v != expectedValue; }))
+                        ++result.numCorrupt;
+
+                    ++expectedSequence;
+                }
+            };
+
+            auto nextDrain = Clock::now();
+
+            while (! stopConsumer.load())
+            {
+                drain();
+                waitForNextDrain(nextDrain, scenario.consumerHz);
+            }
+
+            drain();
+        });
+
+        std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+
+        stopProducer.store(true);
+        producer.join();
+
+        stopConsumer.store(true);
+        consumer.join();
+
+        result.buffersPerSecond = (double) result.numPulled / seconds;
+        result.dropRate = numPushesAttempted > 0 ? (double) numPushesFailed / (double) numPushesAttempted : 0.0;
+        fillInLatencies(result, latencies);
+
+        return result;
+    }
+
+    //==============================================================================
+    bool runAll(double secondsPerScenario)
+    {
+        // name, fifo sizes, block sizes, realtime producer, consumer Hz, prepares per second:
+        const Scenario sampleFifoScenarios[]
+        {
+            { "realtime, 512 blocks, 60Hz analyser",         { 512 },                512, 512,  true,  60.0, 0.0 },
+            { "realtime, varying blocks, re-prepared",       { 128, 256, 512, 1024 }, 16, 1024, true,  60.0, 4.0 },
+            { "flat out, both sides",                        { 64 },                 1, 4096,   false, 0.0,  0.0 },
+            { "flat out, 60Hz analyser",                     { 64 },                 1, 4096,   false, 60.0, 0.0 },
+            { "flat out, re-prepared 50x/s",                 { 32, 64, 256, 4096 },  1, 4096,   false, 0.0,  50.0 },
+        };
+
+        const Scenario vectorFifoScenarios[]
+        {
+            { "realtime, 4096 bin spectra, 60Hz",            { 4096 },               512, 512,  true,  60.0, 0.0 },
+            { "flat out, 4096 bin spectra, both sides",      { 4096 },               512, 512,  false, 0.0,  0.0 },
+            { "flat out, 4096 bin spectra, 60Hz",            { 4096 },               512, 512,  false, 60.0, 0.0 },
+        };
+
+        std::cout << juce::String("fifo / scenario").paddedRight(' ', 62)
+                  << "  buffers/s   drop %   p50 us   p99 us  p99.9 us   worst us  prepares  corrupt" << std::endl;
+
+        int numCorrupt = 0;
+
+        auto print = [&numCorrupt](const juce::String& name, const Result& result)
+        {
+            numCorrupt += result.numCorrupt;
+
+            std::cout << name.paddedRight(' ', 62)
+                      << juce::String(result.buffersPerSecond, 0).paddedLeft(' ', 11)
+                      << juce::String(result.dropRate * 100.0, 2).paddedLeft(' ', 9)
+                      << juce::String(result.p50, 1).paddedLeft(' ', 9)
+                      << juce::String(result.p99, 1).paddedLeft(' ', 9)
+                      << juce::String(result.p999, 1).paddedLeft(' ', 10)
+                      << juce::String(result.worst, 1).paddedLeft(' ', 11)
+                      << juce::String(result.numPrepares).paddedLeft(' ', 10)
+                      << juce::String(result.numCorrupt).paddedLeft(' ', 9)
+                      << std::endl;
+        };
+
+        for (const auto& scenario : sampleFifoScenarios)
+            print("SingleChannelSampleFifo: " + scenario.name, runSampleFifo(scenario, secondsPerScenario));
+
+        for (const auto& scenario : vectorFifoScenarios)
+            print("Fifo<vector<float>>: " + scenario.name, runVectorFifo(scenario, secondsPerScenario));
+
+        std::cout << "Fifo stress test: " << (numCorrupt == 0 ? "passed" : "FAILED") << std::endl;
+
+        return numCorrupt == 0;
+    }
+}
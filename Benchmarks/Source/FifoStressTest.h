@@ -0,0 +1,69 @@
+/*
+  ==============================================================================
+
+    FifoStressTest.h
+
+    Producer/consumer stress test of the fifos between the audio thread and
+    the analyser: SingleChannelSampleFifo (host block sizes, prepare() calls
+    mid-stream) and Fifo<std::vector<float>>, at realtime and flat-out rates.
+
+    Measures throughput, drop rate and the latency from push to pull, and
+    checks every buffer that comes out for corruption. Build with
+    -fsanitize=thread to have ThreadSanitizer check the same runs for races.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <vector>
+
+namespace FifoStressTest
+{
+    struct Scenario
+    {
+        juce::String name;
+
+        // SingleChannelSampleFifo: the sizes it's prepared with, in turn (the host's block size).
+        // Fifo<std::vector<float>>: the size of each vector (one entry).
+        std::vector<int> fifoSizes;
+
+        // Range of the producer's block sizes (update() calls), picked at random:
+        int minBlockSize = 512, maxBlockSize = 512;
+
+        // Producer: paced to realtime at 48kHz, or flat out.
+        bool realtimeProducer = true;
+
+        // Consumer: how often it drains the fifo (the analyser: once per display refresh), or 0 for flat out:
+        double consumerHz = 60.0;
+
+        // Mid-stream prepare() calls (with the producer paused, as a host does), if any:
+        double preparesPerSecond = 0.0;
+    };
+
+    struct Result
+    {
+        double buffersPerSecond = 0.0;
+
+        // Of the buffers pushed (or that would have been), the fraction that never got pulled
+        // (a full fifo, or dropped by prepare()):
+        double dropRate = 0.0;
+
+        // From push to pull (us):
+        double p50 = 0.0, p99 = 0.0, p999 = 0.0, worst = 0.0;
+
+        juce::int64 numPulled = 0;
+        int numPrepares = 0;
+
+        // Buffers that came out torn, out of order or out of step with their stamps:
+        int numCorrupt = 0;
+    };
+
+    Result runSampleFifo(const Scenario& scenario, double seconds);
+    Result runVectorFifo(const Scenario& scenario, double seconds);
+
+    // Runs every scenario, printing a table. Returns false if any buffer came out corrupt:
+    bool runAll(double secondsPerScenario);
+}
@@ -0,0 +1,1442 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    Headless benchmarks of SimpleEQAudioProcessor's DSP: ns/sample of
+    processBlock across block sizes, sample rates, cut slopes and bypass
+    states, with the cost of a coefficient update reported separately.
+
+    Before benchmarking, processBlock is run under the realtime-safety
+    checker; any allocation or mutex lock inside it fails the run (exit
+    code 1) with the offending call stacks.
+
+    --gui benchmarks ResponseCurveComponent instead, painting it into an
+    offscreen image at several sizes and scales (no display needed), with
+    the frame time split into its stages.
+
+    --fifo-stress runs producer/consumer stress tests of the fifos between
+    the audio thread and the analyser instead (throughput, drop rate, push
+    to pull latency); a corrupt buffer fails the run. Build with
+    -fsanitize=thread to check the same runs for data races.
+
+    --bands benchmarks BandEngine (N bands, disabled ones free), and the
+    processor it runs with 3 and 16 bands, against the MonoChain the
+    processor used to run and stacks of it, after checking that the
+    processor sounds the same as that MonoChain, and (with all 16 bands
+    on) as a standalone BandEngine; a mismatch, or 16 bands costing more
+    than 5 stacked MonoChains, fails the run.
+
+    --svf compares the SVF topology with the biquad BandEngine: it checks
+    that both give the same output for the same settings (a mismatch fails
+    the run), then reports the cost of each, steady and under automation,
+    and the largest output step while a parameter sweeps.
+
+    --prepare times prepareToPlay for each kind of spec change (none, block
+    size, sample rate, first call), and checks that a processor taken
+    through the fast paths sounds the same as a freshly prepared one; a
+    mismatch, or a call taking the wrong path, fails the run.
+
+    --recall times setStateInformation for many instances (as a session
+    load does), from the binary state chunk and from the older ValueTree
+    one. Every run first checks the state chunk: a round trip, the older
+    formats, and truncated or corrupt data (which must change nothing); a
+    failure fails the run.
+
+    --gate runs a fixed suite of hot paths (processBlock, the analyser's
+    FFT, response-curve magnitudes and frames) with repetition instead, and compares the
+    medians with the baseline stored for this machine in Benchmarks/Baselines
+    (or, for a machine without one, with the real-time budgets in
+    budget.json there): anything slower by more than the threshold, or no
+    baseline at all, fails the run (exit code 1).
+
+    Usage: SimpleEQBenchmarks [--full] [--seconds <seconds of audio per run>]
+                              [--check-only]
+           SimpleEQBenchmarks --gui [--frames <frames per size, default 300>]
+           SimpleEQBenchmarks --fifo-stress [--seconds <seconds per scenario>]
+           SimpleEQBenchmarks --bands [--seconds <seconds of audio per run>]
+           SimpleEQBenchmarks --svf [--seconds <seconds of audio per run>]
+           SimpleEQBenchmarks --prepare
+           SimpleEQBenchmarks --recall [--instances <n, default 200>]
+           SimpleEQBenchmarks --gate [--threshold <percent, default 10>]
+                              [--repetitions <n, default 7>] [--machine <id>]
+                              [--baselines <directory>] [--update-baseline]
+                              [--json <results file>] [--label <text>]
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+
+#include "../../Source/PluginProcessor.h"
+#include "../../Source/PluginEditor.h"
+#include "FifoStressTest.h"
+#include "PerformanceGate.h"
+#include "RealtimeSafetyChecker.h"
+#include "ResponseCurveBenchmark.h"
+
+#include <iostream>
+
+//==============================================================================
+struct BenchmarkConfig
+{
+    int blockSize = 512;
+    double sampleRate = 48000.0;
+    Slope lowCutSlope = Slope_48, highCutSlope = Slope_48;
+    bool lowCutBypassed = false, peakBypassed = false, highCutBypassed = false;
+    bool svfTopology = false;
+};
+
+struct BenchmarkResult
+{
+    // Steady state, with no parameter changes:
+    double nsPerSample = 0.0;
+
+    // Extra time taken by a block whose parameters changed (the redesign):
+    double updateMicrosecondsPerBlock = 0.0;
+};
+
+static void setParameter(SimpleEQAudioProcessor& processor, Parameters::Index index, float value)
+{
+    auto& parameter = processor.parameterHandles.getParameter(index);
+    parameter.setValueNotifyingHost(parameter.convertTo0to1(value));
+}
+
+// The settings the output checks run with:
+static void setTestSettings(SimpleEQAudioProcessor& processor, bool svfTopology)
+{
+    setParameter(processor, Parameters::LowCutFreq, 120.f);
+    setParameter(processor, Parameters::HighCutFreq, 9000.f);
+    setParameter(processor, Parameters::PeakFreq, 1500.f);
+    setParameter(processor, Parameters::PeakGain, 9.f);
+    setParameter(processor, Parameters::PeakQuality, 2.f);
+    setParameter(processor, Parameters::LowCutSlope, (float) Slope_48);
+    setParameter(processor, Parameters::HighCutSlope, (float) Slope_24);
+    setParameter(processor, Parameters::SvfTopology, svfTopology ? 1.f : 0.f);
+}
+
+// The first 'numEnabled' extra bands on, cycling through every band type (the rest stay bypassed):
+static void setExtraBandParameters(SimpleEQAudioProcessor& processor, int numEnabled)
+{
+    for (int i = 0; i < Parameters::numExtraBands; ++i)
+    {
+        auto set = [&](Parameters::BandField field, float value)
+        {
+            setParameter(processor, Parameters::getBandParameter(i, field), value);
+        };
+
+        set(Parameters::BandBypassed, i < numEnabled ? 0.f : 1.f);
+        set(Parameters::BandFilterType, (float) (i % 5));
+        set(Parameters::BandFreq, juce::mapToLog10((float) (i + 1) / (float) (Parameters::numExtraBands + 1), 40.f, 16000.f));
+        set(Parameters::BandGain, (i & 1) != 0 ? 4.f : -4.f);
+        set(Parameters::BandQuality, 1.4f);
+        set(Parameters::BandSlope, (float) Slope_12);
+    }
+}
+
+static void prepare(SimpleEQAudioProcessor& processor, double sampleRate, int blockSize)
+{
+    // (as a host does)
+    processor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+    processor.prepareToPlay(sampleRate, blockSize);
+}
+
+// The same noise every time, so blocks (and runs) are comparable:
+static void fillWithNoise(juce::AudioBuffer<float>& buffer)
+{
+    juce::Random random(0x5eed);
+
+    for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+        for (int i = 0; i < buffer.getNumSamples(); ++i)
+            buffer.setSample(channel, i, random.nextFloat() - 0.5f);
+}
+
+// Runs 'numBlocks' stereo blocks of the same noise through both (each a callable taking the buffer to process
+// in place), returning the largest difference between their outputs:
+template<typename ProcessA, typename ProcessB>
+static float compareOutputs(int blockSize, int numBlocks, ProcessA&& processA, ProcessB&& processB)
+{
+    juce::AudioBuffer<float> noise(2, blockSize), outputA(2, blockSize), outputB(2, blockSize);
+    fillWithNoise(noise);
+
+    auto maxDifference = 0.f;
+
+    for (int i = 0; i < numBlocks; ++i)
+    {
+        outputA.makeCopyOf(noise, true);
+        outputB.makeCopyOf(noise, true);
+
+        processA(outputA);
+        processB(outputB);
+
+        for (int channel = 0; channel < 2; ++channel)
+            for (int n = 0; n < blockSize; ++n)
+                maxDifference = juce::jmax(maxDifference, std::abs(outputA.getSample(channel, n) - outputB.getSample(channel, n)));
+    }
+
+    return maxDifference;
+}
+
+// Two prepared processors, in blocks of the size the first was prepared with:
+static float compareProcessors(SimpleEQAudioProcessor& a, SimpleEQAudioProcessor& b, int numBlocks)
+{
+    juce::MidiBuffer midi;
+
+    return compareOutputs(a.getBlockSize(), numBlocks,
+                          [&](juce::AudioBuffer<float>& buffer) { a.processBlock(buffer, midi); },
+                          [&](juce::AudioBuffer<float>& buffer) { b.processBlock(buffer, midi); });
+}
+
+static BenchmarkResult runBenchmark(const BenchmarkConfig& config, double secondsOfAudio)
+{
+    SimpleEQAudioProcessor processor;
+
+    setParameter(processor, Parameters::LowCutFreq, 200.f);
+    setParameter(processor, Parameters::HighCutFreq, 8000.f);
+    setParameter(processor, Parameters::PeakFreq, 1000.f);
+    setParameter(processor, Parameters::PeakGain, 6.f);
+    setParameter(processor, Parameters::LowCutSlope, (float) config.lowCutSlope);
+    setParameter(processor, Parameters::HighCutSlope, (float) config.highCutSlope);
+    setParameter(processor, Parameters::LowCutBypassed, config.lowCutBypassed ? 1.f : 0.f);
+    setParameter(processor, Parameters::PeakBypassed, config.peakBypassed ? 1.f : 0.f);
+    setParameter(processor, Parameters::HighCutBypassed, config.highCutBypassed ? 1.f : 0.f);
+    setParameter(processor, Parameters::SvfTopology, config.svfTopology ? 1.f : 0.f);
+
+    prepare(processor, config.sampleRate, config.blockSize);
+
+    // Every block starts from the same noise, so the filters never run away with repeated gain:
+    juce::AudioBuffer<float> noise(2, config.blockSize), buffer(2, config.blockSize);
+    juce::MidiBuffer midi;
+    fillWithNoise(noise);
+
+    auto timeBlock = [&]
+    {
+        buffer.makeCopyOf(noise, true);
+
+        const auto start = juce::Time::getHighResolutionTicks();
+        processor.processBlock(buffer, midi);
+        return juce::Time::getHighResolutionTicks() - start;
+    };
+
+    const auto numBlocks = juce::jmax(16, (int) (secondsOfAudio * config.sampleRate / config.blockSize));
+
+    // Warm up caches and let the initial parameter changes settle:
+    for (int i = 0; i < 16; ++i)
+        timeBlock();
+
+    juce::int64 steadyTicks = 0;
+    for (int i = 0; i < numBlocks; ++i)
+        steadyTicks += timeBlock();
+
+    // A parameter change before every block (outside the timing), as under dense automation:
+    juce::int64 changingTicks = 0;
+    for (int i = 0; i < numBlocks; ++i)
+    {
+        setParameter(processor, Parameters::PeakFreq, (i & 1) != 0 ? 1000.f : 1001.f);
+        changingTicks += timeBlock();
+    }
+
+    processor.releaseResources();
+
+    const auto steadySeconds = juce::Time::highResolutionTicksToSeconds(steadyTicks);
+    const auto changingSeconds = juce::Time::highResolutionTicksToSeconds(changingTicks);
+
+    BenchmarkResult result;
+    result.nsPerSample = steadySeconds * 1.0e9 / ((double) numBlocks * config.blockSize);
+    result.updateMicrosecondsPerBlock = juce::jmax(0.0, changingSeconds - steadySeconds) * 1.0e6 / numBlocks;
+
+    return result;
+}
+
+//==============================================================================
+// Runs processBlock through everything the audio thread has to deal with (steady state, every kind of
+// parameter change, short blocks, preset slots and morphing, with either topology), checking each call.
+// Returns true if clean.
+static bool runRealtimeSafetyCheck()
+{
+    if (! RealtimeSafetyChecker::isSupported())
+    {
+        std::cout << "Realtime-safety check: not supported on this platform/build, skipped" << std::endl;
+        return true;
+    }
+
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 512;
+
+    SimpleEQAudioProcessor processor;
+    prepare(processor, sampleRate, blockSize);
+
+    juce::AudioBuffer<float> noise(2, blockSize), buffer(2, blockSize), shortBuffer(2, blockSize / 3);
+    juce::MidiBuffer midi;
+    fillWithNoise(noise);
+
+    auto processChecked = [&](juce::AudioBuffer<float>& block)
+    {
+        for (int channel = 0; channel < block.getNumChannels(); ++channel)
+            block.copyFrom(channel, 0, noise, channel, 0, block.getNumSamples());
+
+        const RealtimeSafetyChecker::ScopedCheck check;
+        processor.processBlock(block, midi);
+    };
+
+    // Changes are made outside the checked calls, as a host (or the editor) would:
+    auto changeThenProcess = [&](Parameters::Index index, float value)
+    {
+        setParameter(processor, index, value);
+        processChecked(buffer);
+        processChecked(buffer);
+    };
+
+    // Everything twice over, once per filter topology (switching included):
+    for (auto svfTopology : { 0.f, 1.f })
+    {
+        changeThenProcess(Parameters::SvfTopology, svfTopology);
+
+        for (int i = 0; i < 8; ++i)
+            processChecked(buffer);
+
+        changeThenProcess(Parameters::LowCutFreq, 120.f);
+        changeThenProcess(Parameters::HighCutFreq, 9000.f);
+        changeThenProcess(Parameters::PeakFreq, 2500.f);
+        changeThenProcess(Parameters::PeakGain, -9.f);
+        changeThenProcess(Parameters::PeakQuality, 4.f);
+
+        for (auto slope : { Slope_24, Slope_36, Slope_48, Slope_12 })
+        {
+            changeThenProcess(Parameters::LowCutSlope, (float) slope);
+            changeThenProcess(Parameters::HighCutSlope, (float) slope);
+        }
+
+        for (auto bypassed : { 1.f, 0.f })
+        {
+            changeThenProcess(Parameters::LowCutBypassed, bypassed);
+            changeThenProcess(Parameters::PeakBypassed, bypassed);
+            changeThenProcess(Parameters::HighCutBypassed, bypassed);
+        }
+
+        // Extra bands coming on (which rebuilds the cascade), changing type and slope, and going off again:
+        const auto band = [](Parameters::BandField field) { return Parameters::getBandParameter(0, field); };
+
+        changeThenProcess(band(Parameters::BandBypassed), 0.f);
+        changeThenProcess(Parameters::getBandParameter(Parameters::numExtraBands - 1, Parameters::BandBypassed), 0.f);
+        changeThenProcess(band(Parameters::BandFreq), 3000.f);
+
+        for (auto type : { BandType::LowShelf, BandType::HighShelf, BandType::LowCut, BandType::HighCut, BandType::Bell })
+            changeThenProcess(band(Parameters::BandFilterType), (float) (int) type);
+
+        changeThenProcess(band(Parameters::BandSlope), (float) Slope_48);
+        changeThenProcess(band(Parameters::BandBypassed), 1.f);
+
+        changeThenProcess(Parameters::AnalyserEnabled, 0.f);
+
+        // Blocks shorter than prepared, with a change pending:
+        setParameter(processor, Parameters::PeakFreq, 400.f);
+        for (int i = 0; i < 8; ++i)
+            processChecked(shortBuffer);
+
+        // Preset slots: switching and morphing between precomputed designs:
+        processor.presetSlots.store(0, getChainSettings(processor.parameterHandles));
+        setParameter(processor, Parameters::PeakGain, 12.f);
+        processor.presetSlots.store(1, getChainSettings(processor.parameterHandles));
+
+        processor.presetSlots.select(0);
+        processChecked(buffer);
+        processor.presetSlots.select(1);
+        processChecked(buffer);
+
+        for (auto amount : { 0.25f, 0.5f, 1.f })
+        {
+            processor.presetSlots.setMorph(0, amount);
+            processChecked(buffer);
+        }
+
+        processor.presetSlots.select(PresetSlots::noSlot);
+        processChecked(buffer);
+        processChecked(buffer);
+    }
+
+    processor.releaseResources();
+
+    const auto violations = RealtimeSafetyChecker::takeViolations();
+    const auto numDropped = RealtimeSafetyChecker::getNumDroppedViolations();
+
+    for (const auto& violation : violations)
+    {
+        std::cout << "Realtime-safety violation in processBlock: " << violation.function << std::endl;
+
+        for (const auto& frame : violation.callStack)
+            std::cout << "    " << frame << std::endl;
+    }
+
+    if (numDropped > 0)
+        std::cout << "(and " << numDropped << " more)" << std::endl;
+
+    const bool isClean = violations.empty() && numDropped == 0;
+    std::cout << "Realtime-safety check: " << (isClean ? "passed" : "FAILED") << std::endl;
+
+    return isClean;
+}
+
+//==============================================================================
+static const int blockSizes[] { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+static const double sampleRates[] { 44100.0, 48000.0, 88200.0, 96000.0, 176400.0, 192000.0 };
+static const Slope slopes[] { Slope_12, Slope_24, Slope_36, Slope_48 };
+
+static juce::String getSlopeName(Slope slope)
+{
+    return juce::String(12 + (int) slope * 12);
+}
+
+static void printHeader()
+{
+    std::cout << "block      rate  lowcut  highcut  bypassed(L/P/H)  ns/sample  update us/block" << std::endl;
+}
+
+static void printResult(const BenchmarkConfig& config, const BenchmarkResult& result)
+{
+    auto bypassed = juce::String(config.lowCutBypassed ? "L" : "-")
+                  + (config.peakBypassed ? "P" : "-")
+                  + (config.highCutBypassed ? "H" : "-");
+
+    std::cout << juce::String(config.blockSize).paddedLeft(' ', 5)
+              << juce::String(config.sampleRate, 0).paddedLeft(' ', 10)
+              << getSlopeName(config.lowCutSlope).paddedLeft(' ', 8)
+              << getSlopeName(config.highCutSlope).paddedLeft(' ', 9)
+              << bypassed.paddedLeft(' ', 17)
+              << juce::String(result.nsPerSample, 2).paddedLeft(' ', 11)
+              << juce::String(result.updateMicrosecondsPerBlock, 2).paddedLeft(' ', 17)
+              << std::endl;
+}
+
+static void runAndPrint(const BenchmarkConfig& config, double secondsOfAudio)
+{
+    printResult(config, runBenchmark(config, secondsOfAudio));
+}
+
+// A typical layout of 'numBands' bands: 24 dB/Oct cuts at the ends, shelves inside them, bells in between:
+static void setBands(BandEngine& engine, int numBands)
+{
+    for (int i = 0; i < numBands; ++i)
+    {
+        BandSettings band;
+        band.frequency = juce::mapToLog10((float) (i + 1) / (float) (numBands + 1), 20.f, 20000.f);
+        band.gainInDecibels = (i & 1) != 0 ? 4.f : -4.f;
+        band.quality = 1.4f;
+        band.cutOrder = 4;
+        band.enabled = true;
+
+        if (i == 0)                   band.type = BandType::LowCut;
+        else if (i == numBands - 1)   band.type = BandType::HighCut;
+        else if (i == 1)              band.type = BandType::LowShelf;
+        else if (i == numBands - 2)   band.type = BandType::HighShelf;
+        else                          band.type = BandType::Bell;
+
+        engine.setBand(i, band);
+    }
+}
+
+// SimpleEQAudioProcessor (whose filters are a BandEngine now) and the MonoChain pair it used to run, designed
+// with FilterDesign as it was, on the same noise and settings, must agree:
+static bool checkBandEngineMatchesMonoChains()
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 512;
+
+    SimpleEQAudioProcessor processor;
+    setTestSettings(processor, false);
+    prepare(processor, sampleRate, blockSize);
+
+    const auto settings = getChainSettings(processor.parameterHandles);
+    const auto lowCutCoefficients = makeLowCutFilter(settings, sampleRate);
+    const auto peakCoefficients = makePeakFilter(settings, sampleRate);
+    const auto highCutCoefficients = makeHighCutFilter(settings, sampleRate);
+
+    std::array<MonoChain, 2> chains;
+
+    for (auto& chain : chains)
+    {
+        updateCutFilter(chain.get<ChainPositions::LowCut>(), lowCutCoefficients, settings.lowCutSlope);
+        updateCoefficients(chain.get<ChainPositions::Peak>().coefficients, peakCoefficients);
+        updateCutFilter(chain.get<ChainPositions::HighCut>(), highCutCoefficients, settings.highCutSlope);
+
+        chain.prepare({ sampleRate, (juce::uint32) blockSize, 1 });
+    }
+
+    juce::MidiBuffer midi;
+
+    const auto maxDifference = compareOutputs(blockSize, 64,
+                                              [&](juce::AudioBuffer<float>& buffer) { processor.processBlock(buffer, midi); },
+                                              [&](juce::AudioBuffer<float>& buffer)
+                                              {
+                                                  juce::dsp::AudioBlock<float> block(buffer);
+                                                  auto leftBlock = block.getSingleChannelBlock(0);
+                                                  auto rightBlock = block.getSingleChannelBlock(1);
+
+                                                  chains[0].process(juce::dsp::ProcessContextReplacing<float>(leftBlock));
+                                                  chains[1].process(juce::dsp::ProcessContextReplacing<float>(rightBlock));
+                                              });
+
+    processor.releaseResources();
+
+    const bool matches = maxDifference < 1.0e-4f;
+    std::cout << "BandEngine vs MonoChain, max difference " << maxDifference << ": " << (matches ? "passed" : "FAILED") << std::endl;
+
+    return matches;
+}
+
+// The processor with its extra bands on, and a standalone BandEngine given the same bands, must agree (that is,
+// the processor applies every band's parameters, and runs them all):
+static bool checkExtraBandsMatchEngine()
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 512;
+
+    SimpleEQAudioProcessor processor;
+    setTestSettings(processor, false);
+    setExtraBandParameters(processor, Parameters::numExtraBands);
+    prepare(processor, sampleRate, blockSize);
+
+    BandEngine engine;
+    engine.prepare(sampleRate, 2);
+    applyChainSettings(engine, getChainSettings(processor.parameterHandles));
+
+    for (int i = 0; i < Parameters::numExtraBands; ++i)
+        engine.setBand(ChainPositions::HighCut + 1 + i, getBandSettings(processor.parameterHandles, i));
+
+    juce::MidiBuffer midi;
+
+    const auto maxDifference = compareOutputs(blockSize, 64,
+                                              [&](juce::AudioBuffer<float>& buffer) { processor.processBlock(buffer, midi); },
+                                              [&](juce::AudioBuffer<float>& buffer)
+                                              {
+                                                  juce::dsp::AudioBlock<float> block(buffer);
+                                                  engine.process(juce::dsp::ProcessContextReplacing<float>(block));
+                                              });
+
+    processor.releaseResources();
+
+    const bool matches = maxDifference < 1.0e-4f;
+    std::cout << "Processor with 16 bands vs BandEngine, max difference " << maxDifference << ": " << (matches ? "passed" : "FAILED") << std::endl;
+
+    return matches;
+}
+
+// BandEngine with the first 'numEnabled' of 'numBands' typical bands enabled: ns/sample.
+static double measureBandEngine(int numBands, int numEnabled, double secondsOfAudio)
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 512;
+
+    BandEngine engine;
+    engine.prepare(sampleRate, 2);
+    setBands(engine, numBands);
+
+    for (int i = numEnabled; i < numBands; ++i)
+    {
+        auto band = engine.getBand(i);
+        band.enabled = false;
+        engine.setBand(i, band);
+    }
+
+    juce::AudioBuffer<float> noise(2, blockSize), buffer(2, blockSize);
+    fillWithNoise(noise);
+
+    const auto numBlocks = juce::jmax(16, (int) (secondsOfAudio * sampleRate / blockSize));
+    juce::int64 ticks = 0;
+
+    for (int i = 0; i < 16 + numBlocks; ++i)
+    {
+        buffer.makeCopyOf(noise, true);
+        juce::dsp::AudioBlock<float> block(buffer);
+
+        const auto start = juce::Time::getHighResolutionTicks();
+        engine.process(juce::dsp::ProcessContextReplacing<float>(block));
+
+        if (i >= 16)
+            ticks += juce::Time::getHighResolutionTicks() - start;
+    }
+
+    return juce::Time::highResolutionTicksToSeconds(ticks) * 1.0e9 / ((double) numBlocks * blockSize);
+}
+
+// 'numInstances' MonoChain pairs (the processor's filters, without the rest of the plugin) in series, as stacked
+// instances would run them: ns/sample. Each instance is a low cut, a bell and a high cut, like setBands()'s:
+static double measureStackedChains(int numInstances, double secondsOfAudio)
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 512;
+
+    // Left and right:
+    std::vector<std::array<MonoChain, 2>> chains((size_t) numInstances);
+
+    for (int i = 0; i < numInstances; ++i)
+    {
+        ChainSettings settings;
+        settings.lowCutFreq = 30.f;
+        settings.highCutFreq = 18000.f;
+        settings.lowCutSlope = settings.highCutSlope = Slope_24;
+        settings.peakFreq = juce::mapToLog10((float) (i + 1) / (float) (numInstances + 1), 20.f, 20000.f);
+        settings.peakGainInDecibels = (i & 1) != 0 ? 4.f : -4.f;
+        settings.peakQuality = 1.4f;
+
+        // (designed outside the timing, so FilterDesign allocating doesn't matter)
+        const auto lowCutCoefficients = makeLowCutFilter(settings, sampleRate);
+        const auto peakCoefficients = makePeakFilter(settings, sampleRate);
+        const auto highCutCoefficients = makeHighCutFilter(settings, sampleRate);
+
+        for (auto& chain : chains[(size_t) i])
+        {
+            updateCutFilter(chain.get<ChainPositions::LowCut>(), lowCutCoefficients, settings.lowCutSlope);
+            updateCoefficients(chain.get<ChainPositions::Peak>().coefficients, peakCoefficients);
+            updateCutFilter(chain.get<ChainPositions::HighCut>(), highCutCoefficients, settings.highCutSlope);
+
+            chain.prepare({ sampleRate, (juce::uint32) blockSize, 1 });
+        }
+    }
+
+    juce::AudioBuffer<float> noise(2, blockSize), buffer(2, blockSize);
+    fillWithNoise(noise);
+
+    const auto numBlocks = juce::jmax(16, (int) (secondsOfAudio * sampleRate / blockSize));
+    juce::int64 ticks = 0;
+
+    for (int i = 0; i < 16 + numBlocks; ++i)
+    {
+        buffer.makeCopyOf(noise, true);
+        juce::dsp::AudioBlock<float> block(buffer);
+        auto leftBlock = block.getSingleChannelBlock(0);
+        auto rightBlock = block.getSingleChannelBlock(1);
+
+        const auto start = juce::Time::getHighResolutionTicks();
+
+        for (auto& chain : chains)
+        {
+            chain[0].process(juce::dsp::ProcessContextReplacing<float>(leftBlock));
+            chain[1].process(juce::dsp::ProcessContextReplacing<float>(rightBlock));
+        }
+
+        if (i >= 16)
+            ticks += juce::Time::getHighResolutionTicks() - start;
+    }
+
+    return juce::Time::highResolutionTicksToSeconds(ticks) * 1.0e9 / ((double) numBlocks * blockSize);
+}
+
+// The whole processor at 48kHz, 512 sample blocks, with its fixed bands and 'numExtraEnabled' extra ones: ns/sample.
+static double measureProcessorBands(int numExtraEnabled, double secondsOfAudio)
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 512;
+
+    SimpleEQAudioProcessor processor;
+    setTestSettings(processor, false);
+    setExtraBandParameters(processor, numExtraEnabled);
+    prepare(processor, sampleRate, blockSize);
+
+    juce::AudioBuffer<float> noise(2, blockSize), buffer(2, blockSize);
+    juce::MidiBuffer midi;
+    fillWithNoise(noise);
+
+    const auto numBlocks = juce::jmax(16, (int) (secondsOfAudio * sampleRate / blockSize));
+    juce::int64 ticks = 0;
+
+    for (int i = 0; i < 16 + numBlocks; ++i)
+    {
+        buffer.makeCopyOf(noise, true);
+
+        const auto start = juce::Time::getHighResolutionTicks();
+        processor.processBlock(buffer, midi);
+
+        if (i >= 16)
+            ticks += juce::Time::getHighResolutionTicks() - start;
+    }
+
+    processor.releaseResources();
+
+    return juce::Time::highResolutionTicksToSeconds(ticks) * 1.0e9 / ((double) numBlocks * blockSize);
+}
+
+// Returns false if the processor doesn't match its old MonoChains or a standalone BandEngine, or 16 bands cost
+// more than 5 stacked MonoChains:
+static bool runBandEngineBenchmarks(double secondsOfAudio)
+{
+    // (both run, so a failure in the first doesn't hide one in the second)
+    const bool matchesMonoChains = checkBandEngineMatchesMonoChains();
+    const bool matchesEngine = checkExtraBandsMatchEngine();
+
+    if (! matchesMonoChains || ! matchesEngine)
+        return false;
+
+    auto print = [](const juce::String& name, double nsPerSample)
+    {
+        std::cout << name.paddedRight(' ', 48) << juce::String(nsPerSample, 2).paddedLeft(' ', 10) << std::endl;
+    };
+
+    std::cout << juce::String("512 samples @ 48kHz, stereo").paddedRight(' ', 48) << " ns/sample" << std::endl;
+
+    const auto oneInstance = measureStackedChains(1, secondsOfAudio);
+    const auto fiveInstances = measureStackedChains(5, secondsOfAudio);
+    const auto sixteenBands = measureBandEngine(16, 16, secondsOfAudio);
+
+    print("MonoChain", oneInstance);
+    print("5 stacked MonoChains", fiveInstances);
+    print("BandEngine, 3 bands", measureBandEngine(3, 3, secondsOfAudio));
+    print("BandEngine, 8 bands", measureBandEngine(8, 8, secondsOfAudio));
+    print("BandEngine, 16 bands", sixteenBands);
+    print("BandEngine, 16 bands of which 3 enabled", measureBandEngine(16, 3, secondsOfAudio));
+    print("BandEngine, 16 bands, all disabled", measureBandEngine(16, 0, secondsOfAudio));
+    print("SimpleEQAudioProcessor, 3 bands", measureProcessorBands(0, secondsOfAudio));
+    print("SimpleEQAudioProcessor, 16 bands", measureProcessorBands(Parameters::numExtraBands, secondsOfAudio));
+
+    const auto ratio = fiveInstances > 0.0 ? sixteenBands / fiveInstances : 0.0;
+    const bool cheaper = ratio < 1.0;
+
+    std::cout << "16 bands cost " << juce::String(ratio * 100.0, 1) << "% of 5 stacked MonoChains: "
+              << (cheaper ? "passed" : "FAILED") << std::endl;
+
+    return cheaper;
+}
+
+//==============================================================================
+// The two topologies, on the same noise and settings, must agree (to within float rounding, which differs):
+static bool checkSvfMatchesBiquads()
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 512;
+
+    // (extra bands included: they run in the BandEngine either way, after the fixed ones)
+    SimpleEQAudioProcessor biquads, svfs;
+    setTestSettings(biquads, false);
+    setTestSettings(svfs, true);
+    setExtraBandParameters(biquads, 4);
+    setExtraBandParameters(svfs, 4);
+
+    prepare(biquads, sampleRate, blockSize);
+    prepare(svfs, sampleRate, blockSize);
+
+    const auto maxDifference = compareProcessors(biquads, svfs, 64);
+
+    biquads.releaseResources();
+    svfs.releaseResources();
+
+    const bool matches = maxDifference < 1.0e-3f;
+    std::cout << "SvfChain vs BandEngine, max difference " << maxDifference << ": " << (matches ? "passed" : "FAILED") << std::endl;
+
+    return matches;
+}
+
+// A 1kHz sine through the peak while its frequency sweeps 200Hz-5kHz and back twice a second, automated
+// every 64 sample block: the largest step between consecutive output samples (clicks show up as outliers).
+static float measureLargestStepUnderSweep(bool svfTopology)
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 64;
+
+    SimpleEQAudioProcessor processor;
+    setTestSettings(processor, svfTopology);
+    setParameter(processor, Parameters::LowCutBypassed, 1.f);
+    setParameter(processor, Parameters::HighCutBypassed, 1.f);
+    setParameter(processor, Parameters::PeakGain, 18.f);
+    setParameter(processor, Parameters::PeakQuality, 4.f);
+
+    prepare(processor, sampleRate, blockSize);
+
+    juce::AudioBuffer<float> buffer(2, blockSize);
+    juce::MidiBuffer midi;
+
+    const auto phaseIncrement = juce::MathConstants<double>::twoPi * 1000.0 / sampleRate;
+    double phase = 0.0;
+    float previous = 0.f, largestStep = 0.f;
+
+    for (int block = 0; block < (int) (2.0 * sampleRate / blockSize); ++block)
+    {
+        const auto sweepPosition = std::abs(std::fmod(block * blockSize / sampleRate * 2.0, 2.0) - 1.0);
+        setParameter(processor, Parameters::PeakFreq, juce::mapToLog10((float) sweepPosition, 200.f, 5000.f));
+
+        for (int i = 0; i < blockSize; ++i)
+        {
+            const auto sample = 0.25f * (float) std::sin(phase);
+            phase = std::fmod(phase + phaseIncrement, juce::MathConstants<double>::twoPi);
+
+            buffer.setSample(0, i, sample);
+            buffer.setSample(1, i, sample);
+        }
+
+        processor.processBlock(buffer, midi);
+
+        for (int i = 0; i < blockSize; ++i)
+        {
+            largestStep = juce::jmax(largestStep, std::abs(buffer.getSample(0, i) - previous));
+            previous = buffer.getSample(0, i);
+        }
+    }
+
+    processor.releaseResources();
+
+    return largestStep;
+}
+
+// Returns false if the topologies don't match:
+static bool runSvfBenchmarks(double secondsOfAudio)
+{
+    if (! checkSvfMatchesBiquads())
+        return false;
+
+    std::cout << "topology  block      rate  ns/sample  update us/block" << std::endl;
+
+    for (auto blockSize : { 64, 512 })
+        for (auto svfTopology : { false, true })
+        {
+            BenchmarkConfig config;
+            config.blockSize = blockSize;
+            config.svfTopology = svfTopology;
+
+            const auto result = runBenchmark(config, secondsOfAudio);
+
+            std::cout << juce::String(svfTopology ? "svf" : "biquad").paddedRight(' ', 8)
+                      << juce::String(config.blockSize).paddedLeft(' ', 7)
+                      << juce::String(config.sampleRate, 0).paddedLeft(' ', 10)
+                      << juce::String(result.nsPerSample, 2).paddedLeft(' ', 11)
+                      << juce::String(result.updateMicrosecondsPerBlock, 2).paddedLeft(' ', 17)
+                      << std::endl;
+        }
+
+    std::cout << "Largest output step, peak sweeping under a sine: biquad " << measureLargestStepUnderSweep(false)
+              << ", svf " << measureLargestStepUnderSweep(true) << std::endl;
+
+    return true;
+}
+
+//==============================================================================
+static juce::String getPrepareKindName(SimpleEQAudioProcessor::PrepareKind kind)
+{
+    switch (kind)
+    {
+        case SimpleEQAudioProcessor::PrepareKind::Full:             return "first call (full)";
+        case SimpleEQAudioProcessor::PrepareKind::SampleRateChange: return "sample rate change";
+        case SimpleEQAudioProcessor::PrepareKind::BlockSizeChange:  return "block size change";
+        case SimpleEQAudioProcessor::PrepareKind::Unchanged:        return "unchanged";
+    }
+
+    return {};
+}
+
+// A processor taken through every fast path must end up sounding like one prepared from scratch:
+static bool checkReprepareMatchesFresh()
+{
+    SimpleEQAudioProcessor reprepared, fresh;
+    setTestSettings(reprepared, false);
+    setTestSettings(fresh, false);
+
+    juce::AudioBuffer<float> noise(2, 256), buffer(2, 256);
+    juce::MidiBuffer midi;
+    fillWithNoise(noise);
+
+    auto processNoise = [&]
+    {
+        buffer.makeCopyOf(noise, true);
+        reprepared.processBlock(buffer, midi);
+    };
+
+    // Through every path, with audio in between to leave state behind:
+    prepare(reprepared, 48000.0, 512);
+    processNoise();
+    prepare(reprepared, 44100.0, 512);
+    processNoise();
+    prepare(reprepared, 48000.0, 512);
+    prepare(reprepared, 48000.0, 512);
+    processNoise();
+    prepare(reprepared, 48000.0, 256);
+    processNoise();
+    prepare(reprepared, 44100.0, 256);
+
+    prepare(fresh, 44100.0, 256);
+
+    const auto maxDifference = compareProcessors(reprepared, fresh, 16);
+
+    const bool matches = maxDifference == 0.f;
+    std::cout << "Re-prepared vs freshly prepared, max difference " << maxDifference << ": " << (matches ? "passed" : "FAILED") << std::endl;
+
+    return matches;
+}
+
+// Returns false if a re-prepared processor doesn't match a fresh one, or a call took the wrong path:
+static bool runPrepareBenchmarks()
+{
+    using PrepareKind = SimpleEQAudioProcessor::PrepareKind;
+
+    if (! checkReprepareMatchesFresh())
+        return false;
+
+    constexpr int numCalls = 200;
+    bool tookExpectedPaths = true;
+
+    // Mean time per call, after checking that each call took the path expected of it:
+    auto timeCalls = [&](const juce::String& name, PrepareKind expectedKind, auto&& makeCall)
+    {
+        auto totalMs = 0.0;
+
+        for (int i = 0; i < numCalls; ++i)
+        {
+            auto& processor = makeCall(i);
+            tookExpectedPaths &= processor.getLastPrepareKind() == expectedKind;
+            totalMs += processor.getLastPrepareTimeMs();
+        }
+
+        std::cout << name.paddedRight(' ', 40) << juce::String(totalMs * 1000.0 / numCalls, 2).paddedLeft(' ', 10) << std::endl;
+    };
+
+    SimpleEQAudioProcessor processor;
+    setTestSettings(processor, false);
+
+    // Preset slots take part in a rate change too:
+    processor.presetSlots.store(0, getChainSettings(processor.parameterHandles));
+    processor.presetSlots.store(1, getChainSettings(processor.parameterHandles));
+
+    std::cout << juce::String("prepareToPlay").paddedRight(' ', 40) << "   us/call" << std::endl;
+
+    // A fresh processor for each first call (constructed up front; prepareToPlay() times only itself):
+    std::vector<std::unique_ptr<SimpleEQAudioProcessor>> freshProcessors;
+    for (int i = 0; i < numCalls; ++i)
+        freshProcessors.push_back(std::make_unique<SimpleEQAudioProcessor>());
+
+    timeCalls(getPrepareKindName(PrepareKind::Full), PrepareKind::Full,
+              [&](int i) -> SimpleEQAudioProcessor& { prepare(*freshProcessors[(size_t) i], 48000.0, 512); return *freshProcessors[(size_t) i]; });
+
+    prepare(processor, 48000.0, 512);
+
+    timeCalls(getPrepareKindName(PrepareKind::Unchanged), PrepareKind::Unchanged,
+              [&](int) -> SimpleEQAudioProcessor& { prepare(processor, 48000.0, 512); return processor; });
+    timeCalls(getPrepareKindName(PrepareKind::BlockSizeChange), PrepareKind::BlockSizeChange,
+              [&](int i) -> SimpleEQAudioProcessor& { prepare(processor, 48000.0, (i & 1) != 0 ? 512 : 256); return processor; });
+
+    // Toggling between two rates (designs cached), then a new rate every call (designed afresh):
+    timeCalls(getPrepareKindName(PrepareKind::SampleRateChange) + " (44.1/48kHz)", PrepareKind::SampleRateChange,
+              [&](int i) -> SimpleEQAudioProcessor& { prepare(processor, (i & 1) != 0 ? 48000.0 : 44100.0, 256); return processor; });
+    timeCalls(getPrepareKindName(PrepareKind::SampleRateChange) + " (new rate)", PrepareKind::SampleRateChange,
+              [&](int i) -> SimpleEQAudioProcessor& { prepare(processor, 32000.0 + i * 100.0, 256); return processor; });
+
+    for (auto& freshProcessor : freshProcessors)
+        freshProcessor->releaseResources();
+
+    processor.releaseResources();
+
+    std::cout << "prepareToPlay paths: " << (tookExpectedPaths ? "passed" : "FAILED") << std::endl;
+    return tookExpectedPaths;
+}
+
+//==============================================================================
+// Every parameter's (normalised) value, in getParameters() order, which is also the order of the state chunk:
+static std::vector<float> getParameterValues(SimpleEQAudioProcessor& processor)
+{
+    std::vector<float> values;
+
+    for (auto* parameter : processor.getParameters())
+        values.push_back(parameter->getValue());
+
+    return values;
+}
+
+// The format sessions were saved in before the binary chunk: the whole apvts ValueTree.
+static juce::MemoryBlock getLegacyState(SimpleEQAudioProcessor& processor)
+{
+    juce::MemoryBlock block;
+    juce::MemoryOutputStream mos(block, false);
+    processor.apvts.copyState().writeToStream(mos);
+    mos.flush();
+
+    return block;
+}
+
+// A binary chunk as an older build (version 1: no preset slots, and only the first 'numParameters' parameters)
+// would have saved it:
+static juce::MemoryBlock withFewerParameters(const juce::MemoryBlock& chunk, int numParameters)
+{
+    juce::MemoryInputStream mis(chunk, false);
+    juce::MemoryBlock older;
+    juce::MemoryOutputStream mos(older, false);
+
+    mos.writeInt(mis.readInt());    // magic
+    mis.readInt();
+    mos.writeInt(1);
+    mis.readInt();
+    mos.writeInt(numParameters);
+
+    for (int i = 0; i < numParameters; ++i)
+        mos.writeFloat(mis.readFloat());
+
+    mos.flush();
+    return older;
+}
+
+// (restored values go through convertFrom0to1/convertTo0to1 and back, so allow for rounding)
+static bool valuesMatch(const std::vector<float>& a, const std::vector<float>& b)
+{
+    if (a.size() != b.size())
+        return false;
+
+    for (size_t i = 0; i < a.size(); ++i)
+        if (std::abs(a[i] - b[i]) > 1.0e-5f)
+            return false;
+
+    return true;
+}
+
+// Settings away from every default the state has to carry, with two preset slots stored and morphing:
+static void setRecallTestSettings(SimpleEQAudioProcessor& processor)
+{
+    setTestSettings(processor, false);
+    processor.presetSlots.store(1, getChainSettings(processor.parameterHandles));
+
+    setTestSettings(processor, true);
+    setParameter(processor, Parameters::LowCutBypassed, 1.f);
+    setParameter(processor, Parameters::AnalyserEnabled, 0.f);
+    setExtraBandParameters(processor, 1);
+    processor.presetSlots.store(3, getChainSettings(processor.parameterHandles));
+
+    processor.presetSlots.select(3);
+    processor.presetSlots.setMorph(1, 0.25f);
+}
+
+static bool presetSlotsMatch(const PresetSlots& a, const PresetSlots& b)
+{
+    for (int i = 0; i < PresetSlots::numSlots; ++i)
+        if (a.isSlotStored(i) != b.isSlotStored(i))
+            return false;
+
+    PresetSlots::ActiveSettings activeA, activeB;
+
+    if (a.getActiveSettings(activeA) != b.getActiveSettings(activeB))
+        return false;
+
+    return activeA.slot == activeB.slot && activeA.target == activeB.target && activeA.amount == activeB.amount
+        && a.getSelectedSlot() == b.getSelectedSlot() && a.getMorphTargetSlot() == b.getMorphTargetSlot();
+}
+
+// Round trip, old formats and bad data through setStateInformation(). Returns true if all behaved:
+static bool checkStateRecall()
+{
+    SimpleEQAudioProcessor source;
+    setRecallTestSettings(source);
+
+    const auto sourceValues = getParameterValues(source);
+    const auto numParameters = (int) sourceValues.size();
+
+    juce::MemoryBlock chunk;
+    source.getStateInformation(chunk);
+
+    bool passed = true;
+
+    auto report = [&passed](const juce::String& name, bool ok)
+    {
+        std::cout << ("State recall, " + name + ": ").paddedRight(' ', 48) << (ok ? "passed" : "FAILED") << std::endl;
+        passed &= ok;
+    };
+
+    auto restore = [](SimpleEQAudioProcessor& processor, const juce::MemoryBlock& block)
+    {
+        processor.setStateInformation(block.getData(), (int) block.getSize());
+        return getParameterValues(processor);
+    };
+
+    {
+        SimpleEQAudioProcessor restored;
+        report("binary round trip", valuesMatch(restore(restored, chunk), sourceValues));
+        report("preset slots round trip", presetSlotsMatch(restored.presetSlots, source.presetSlots));
+    }
+
+    {
+        SimpleEQAudioProcessor restored;
+        report("legacy ValueTree chunk", valuesMatch(restore(restored, getLegacyState(source)), sourceValues));
+    }
+
+    // Parameters missing from an older chunk get their defaults: here, one from before the extra bands (Band 4 is
+    // on in the source), and one a parameter short of that (SVF Topology is on in the source):
+    for (const auto numStored : { (int) Parameters::NumFixedParameters, (int) Parameters::NumFixedParameters - 1 })
+    {
+        SimpleEQAudioProcessor restored;
+        const auto values = restore(restored, withFewerParameters(chunk, numStored));
+
+        auto expected = sourceValues;
+
+        for (int i = numStored; i < numParameters; ++i)
+            expected[(size_t) i] = restored.getParameters()[i]->getDefaultValue();
+
+        report("version 1 chunk with " + juce::String(numStored) + " parameters", valuesMatch(values, expected));
+    }
+
+    // Truncated, corrupt or foreign data leaves the current state alone:
+    {
+        SimpleEQAudioProcessor restored;
+        setRecallTestSettings(restored);
+
+        juce::MemoryBlock truncated(chunk.getData(), chunk.getSize() - 2);
+
+        // (the count is the third int of the header)
+        juce::MemoryBlock hugeCount(chunk);
+        const auto maxCount = juce::ByteOrder::swapIfBigEndian(std::numeric_limits<int>::max());
+        hugeCount.copyFrom(&maxCount, 2 * (int) sizeof(int), sizeof(int));
+
+        juce::MemoryBlock garbage(chunk.getSize());
+        juce::Random random(0x5eed);
+        random.fillBitsRandomly(garbage.getData(), garbage.getSize());
+
+        juce::MemoryBlock empty;
+
+        bool untouched = true;
+
+        for (const auto* bad : { &truncated, &hugeCount, &garbage, &empty })
+            untouched &= valuesMatch(restore(restored, *bad), sourceValues);
+
+        report("truncated and corrupt chunks", untouched && presetSlotsMatch(restored.presetSlots, source.presetSlots));
+    }
+
+    return passed;
+}
+
+// 'numInstances' instances each restoring the same chunk, as when a session loads: mean us/instance.
+static double measureRecall(const juce::MemoryBlock& chunk, int numInstances)
+{
+    // (constructed up front; getLastStateRecallTimeMs() times only setStateInformation() itself)
+    std::vector<std::unique_ptr<SimpleEQAudioProcessor>> instances;
+    for (int i = 0; i < numInstances; ++i)
+        instances.push_back(std::make_unique<SimpleEQAudioProcessor>());
+
+    auto totalMs = 0.0;
+
+    for (auto& instance : instances)
+    {
+        instance->setStateInformation(chunk.getData(), (int) chunk.getSize());
+        totalMs += instance->getLastStateRecallTimeMs();
+    }
+
+    return totalMs * 1000.0 / numInstances;
+}
+
+static void runRecallBenchmarks(int numInstances)
+{
+    SimpleEQAudioProcessor source;
+    setRecallTestSettings(source);
+
+    juce::MemoryBlock chunk;
+    source.getStateInformation(chunk);
+    const auto legacyChunk = getLegacyState(source);
+
+    const auto binaryMicroseconds = measureRecall(chunk, numInstances);
+    const auto legacyMicroseconds = measureRecall(legacyChunk, numInstances);
+
+    std::cout << "setStateInformation, " << numInstances << " instances" << std::endl;
+    std::cout << juce::String("format").paddedRight(' ', 28) << "   bytes  us/instance  ms/session" << std::endl;
+
+    auto print = [numInstances](const juce::String& name, size_t size, double microseconds)
+    {
+        std::cout << name.paddedRight(' ', 28)
+                  << juce::String((int) size).paddedLeft(' ', 8)
+                  << juce::String(microseconds, 2).paddedLeft(' ', 13)
+                  << juce::String(microseconds * numInstances / 1000.0, 2).paddedLeft(' ', 12)
+                  << std::endl;
+    };
+
+    print("binary chunk", chunk.getSize(), binaryMicroseconds);
+    print("legacy ValueTree chunk", legacyChunk.getSize(), legacyMicroseconds);
+}
+
+//==============================================================================
+// The analyser's FFT work for 'secondsOfAudio' of noise, fed in 512 sample blocks at 48kHz: ns/sample.
+static double measureAnalyzerFFT(double secondsOfAudio)
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 512;
+    constexpr float negativeInfinity = -48.f;
+
+    MultiResolutionFFTDataGenerator<std::vector<float>> generator;
+    generator.prepare(FFTOrder::order2048, sampleRate, negativeInfinity);
+
+    juce::AudioBuffer<float> noise(1, blockSize);
+    fillWithNoise(noise);
+
+    std::vector<float> spectrum;
+    const auto numBlocks = juce::jmax(16, (int) (secondsOfAudio * sampleRate / blockSize));
+
+    const auto start = juce::Time::getHighResolutionTicks();
+
+    for (int i = 0; i < numBlocks; ++i)
+    {
+        generator.produceFFTDataForRendering(noise, negativeInfinity);
+
+        while (generator.getNumAvailableFFTDataBlocks() > 0)
+            generator.getFFTData(spectrum);
+    }
+
+    const auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+    return seconds * 1.0e9 / ((double) numBlocks * blockSize);
+}
+
+// The response curve's magnitudes (peak section plus both 48 dB/Oct cuts) over a 1000 pixel wide grid: us/frame.
+static double measureResponseCurveMagnitudes()
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int numPoints = 1000;
+    constexpr int numFrames = 2000;
+
+    ChainSettings settings;
+    settings.lowCutFreq = 200.f;
+    settings.highCutFreq = 8000.f;
+    settings.peakFreq = 1000.f;
+    settings.peakGainInDecibels = 6.f;
+    settings.lowCutSlope = Slope_48;
+    settings.highCutSlope = Slope_48;
+
+    const auto peakCoefficients = makePeakFilter(settings, sampleRate);
+
+    BiquadMagnitudeEvaluator evaluator;
+    evaluator.prepare(numPoints, sampleRate);
+
+    std::vector<double> magnitudes((size_t) numPoints);
+
+    const auto start = juce::Time::getHighResolutionTicks();
+
+    for (int frame = 0; frame < numFrames; ++frame)
+    {
+        std::fill(magnitudes.begin(), magnitudes.end(), 1.0);
+        evaluator.multiplyMagnitudes(*peakCoefficients, magnitudes.data());
+        evaluator.multiplyButterworthMagnitudes(true, settings.lowCutFreq, (settings.lowCutSlope + 1) * 2, magnitudes.data());
+        evaluator.multiplyButterworthMagnitudes(false, settings.highCutFreq, (settings.highCutSlope + 1) * 2, magnitudes.data());
+    }
+
+    const auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+    return seconds * 1.0e6 / numFrames;
+}
+
+static std::vector<PerformanceGate::Result> runGateSuite(int repetitions, double secondsOfAudio)
+{
+    std::vector<PerformanceGate::Result> results;
+
+    auto processBlockResult = [&](int blockSize, double sampleRate)
+    {
+        BenchmarkConfig config;
+        config.blockSize = blockSize;
+        config.sampleRate = sampleRate;
+
+        const auto name = "processBlock " + juce::String(blockSize) + " @ " + juce::String(sampleRate / 1000.0, 1) + "kHz";
+
+        results.push_back(PerformanceGate::measure(name, "ns/sample", repetitions,
+                                                   [&] { return runBenchmark(config, secondsOfAudio).nsPerSample; }));
+    };
+
+    processBlockResult(512, 48000.0);
+    processBlockResult(64, 48000.0);
+    processBlockResult(512, 192000.0);
+
+    results.push_back(PerformanceGate::measure("coefficient update 512 @ 48.0kHz", "us/block", repetitions,
+                                               [&] { return runBenchmark(BenchmarkConfig(), secondsOfAudio).updateMicrosecondsPerBlock; }));
+
+    results.push_back(PerformanceGate::measure("svf coefficient update 512 @ 48.0kHz", "us/block", repetitions, [&]
+    {
+        BenchmarkConfig config;
+        config.svfTopology = true;
+        return runBenchmark(config, secondsOfAudio).updateMicrosecondsPerBlock;
+    }));
+
+    results.push_back(PerformanceGate::measure("analyser FFT 512 @ 48.0kHz", "ns/sample", repetitions,
+                                               [&] { return measureAnalyzerFFT(secondsOfAudio); }));
+
+    results.push_back(PerformanceGate::measure("band engine 16 bands 512 @ 48.0kHz", "ns/sample", repetitions,
+                                               [&] { return measureBandEngine(16, 16, secondsOfAudio); }));
+
+    results.push_back(PerformanceGate::measure("response curve magnitudes 1000 points", "us/frame", repetitions,
+                                               [] { return measureResponseCurveMagnitudes(); }));
+
+    results.push_back(PerformanceGate::measure("response curve frame 480x117 @ 1x", "us/frame", repetitions,
+                                               [] { return ResponseCurveBenchmark::run({}, 120).getTotal(); }));
+
+    return results;
+}
+
+// Returns false if the gate failed (a regression, or results that couldn't be written):
+static bool runGate(const juce::StringArray& args, double secondsOfAudio)
+{
+    auto getOption = [&](const juce::String& name, const juce::String& defaultValue)
+    {
+        const auto index = args.indexOf(name);
+        return index >= 0 && index + 1 < args.size() ? args[index + 1] : defaultValue;
+    };
+
+    const auto threshold = juce::jmax(0.0, getOption("--threshold", "10").getDoubleValue()) / 100.0;
+    const auto repetitions = juce::jmax(1, getOption("--repetitions", "7").getIntValue());
+    const auto machineID = getOption("--machine", PerformanceGate::getDefaultMachineID());
+    const auto baselineDirectory = juce::File::getCurrentWorkingDirectory()
+                                       .getChildFile(getOption("--baselines", "Benchmarks/Baselines"));
+    const auto baselineFile = baselineDirectory.getChildFile(machineID + ".json");
+
+    std::cout << "Performance gate on " << machineID << ", " << repetitions << " repetitions" << std::endl;
+
+    const auto results = runGateSuite(repetitions, secondsOfAudio);
+    const auto json = PerformanceGate::toJSON(results, machineID, getOption("--label", {}));
+
+    const auto jsonPath = getOption("--json", {});
+    if (jsonPath.isNotEmpty() && ! PerformanceGate::writeJSON(juce::File::getCurrentWorkingDirectory().getChildFile(jsonPath), json))
+    {
+        std::cout << "Couldn't write " << jsonPath << std::endl;
+        return false;
+    }
+
+    if (args.contains("--update-baseline"))
+    {
+        if (! PerformanceGate::writeJSON(baselineFile, json))
+        {
+            std::cout << "Couldn't write " << baselineFile.getFullPathName() << std::endl;
+            return false;
+        }
+
+        std::cout << "Baseline written to " << baselineFile.getFullPathName() << std::endl;
+        return true;
+    }
+
+    // Machines without a baseline of their own are held to the real-time budgets instead:
+    const auto budgetFile = baselineDirectory.getChildFile("budget.json");
+
+    if (! baselineFile.existsAsFile() && budgetFile.existsAsFile())
+    {
+        std::cout << "No baseline for " << machineID << ", comparing with the budgets in " << budgetFile.getFullPathName() << std::endl;
+        return PerformanceGate::compareWithBaseline(results, budgetFile, threshold);
+    }
+
+    return PerformanceGate::compareWithBaseline(results, baselineFile, threshold);
+}
+
+//==============================================================================
+static void runResponseCurveBenchmarks(int numFrames)
+{
+    // The editor's default size, then larger (resized editors, big screens):
+    const std::pair<int, int> sizes[] { { 480, 117 }, { 800, 200 }, { 1200, 300 }, { 1920, 480 } };
+    const float scales[] { 1.f, 1.5f, 2.f };
+
+    std::cout << "     size  scale  resize ms  magnitudes  analyser paths  curve path  stroking     paint  total us/frame" << std::endl;
+
+    for (const auto& size : sizes)
+        for (auto scale : scales)
+        {
+            ResponseCurveBenchmark::Config config;
+            config.width = size.first;
+            config.height = size.second;
+            config.scale = scale;
+
+            const auto result = ResponseCurveBenchmark::run(config, numFrames);
+
+            std::cout << (juce::String(size.first) + "x" + juce::String(size.second)).paddedLeft(' ', 9)
+                      << juce::String(scale, 1).paddedLeft(' ', 7)
+                      << juce::String(result.resizeMs, 2).paddedLeft(' ', 11)
+                      << juce::String(result.magnitudes, 1).paddedLeft(' ', 12)
+                      << juce::String(result.analyserPaths, 1).paddedLeft(' ', 16)
+                      << juce::String(result.curvePath, 1).paddedLeft(' ', 12)
+                      << juce::String(result.stroking, 1).paddedLeft(' ', 10)
+                      << juce::String(result.paint, 1).paddedLeft(' ', 10)
+                      << juce::String(result.getTotal(), 1).paddedLeft(' ', 16)
+                      << std::endl;
+        }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    // (AudioProcessorValueTreeState needs a message manager for its timer)
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::StringArray args;
+    for (int i = 1; i < argc; ++i)
+        args.add(argv[i]);
+
+    const bool fullSweep = args.contains("--full");
+    const auto secondsIndex = args.indexOf("--seconds");
+    const auto secondsOfAudio = secondsIndex >= 0 ? juce::jmax(0.01, args[secondsIndex + 1].getDoubleValue()) : 2.0;
+
+    // A benchmark of code that isn't realtime-safe isn't worth much:
+    if (! runRealtimeSafetyCheck())
+        return 1;
+
+    // Nor is a plugin that can't get its sessions back:
+    if (! checkStateRecall())
+        return 1;
+
+    if (args.contains("--check-only"))
+        return 0;
+
+    if (args.contains("--prepare"))
+        return runPrepareBenchmarks() ? 0 : 1;
+
+    if (args.contains("--recall"))
+    {
+        const auto instancesIndex = args.indexOf("--instances");
+        runRecallBenchmarks(instancesIndex >= 0 ? juce::jmax(1, args[instancesIndex + 1].getIntValue()) : 200);
+        return 0;
+    }
+
+    if (args.contains("--svf"))
+        return runSvfBenchmarks(secondsOfAudio) ? 0 : 1;
+
+    if (args.contains("--bands"))
+        return runBandEngineBenchmarks(secondsOfAudio) ? 0 : 1;
+
+    if (args.contains("--fifo-stress"))
+        return FifoStressTest::runAll(secondsOfAudio) ? 0 : 1;
+
+    if (args.contains("--gui"))
+    {
+        const auto framesIndex = args.indexOf("--frames");
+        runResponseCurveBenchmarks(framesIndex >= 0 ? juce::jmax(1, args[framesIndex + 1].getIntValue()) : 300);
+        return 0;
+    }
+
+    if (args.contains("--gate"))
+        return runGate(args, secondsIndex >= 0 ? secondsOfAudio : 0.5) ? 0 : 1;
+
+    printHeader();
+
+    if (fullSweep)
+    {
+        // Every combination (slow):
+        for (auto blockSize : blockSizes)
+            for (auto sampleRate : sampleRates)
+                for (auto lowCutSlope : slopes)
+                    for (auto highCutSlope : slopes)
+                        for (int bypassState = 0; bypassState < 8; ++bypassState)
+                        {
+                            BenchmarkConfig config { blockSize, sampleRate, lowCutSlope, highCutSlope,
+                                                     (bypassState & 1) != 0, (bypassState & 2) != 0, (bypassState & 4) != 0 };
+                            runAndPrint(config, secondsOfAudio);
+                        }
+
+        return 0;
+    }
+
+    // One axis at a time, around a 512 sample / 48kHz / 48 dB/Oct / nothing bypassed default:
+    for (auto blockSize : blockSizes)
+        for (auto sampleRate : sampleRates)
+        {
+            BenchmarkConfig config;
+            config.blockSize = blockSize;
+            config.sampleRate = sampleRate;
+            runAndPrint(config, secondsOfAudio);
+        }
+
+    for (auto lowCutSlope : slopes)
+        for (auto highCutSlope : slopes)
+        {
+            BenchmarkConfig config;
+            config.lowCutSlope = lowCutSlope;
+            config.highCutSlope = highCutSlope;
+            runAndPrint(config, secondsOfAudio);
+        }
+
+    for (int bypassState = 1; bypassState < 8; ++bypassState)
+    {
+        BenchmarkConfig config;
+        config.lowCutBypassed = (bypassState & 1) != 0;
+        config.peakBypassed = (bypassState & 2) != 0;
+        config.highCutBypassed = (bypassState & 4) != 0;
+        runAndPrint(config, secondsOfAudio);
+    }
+
+    return 0;
+}
@@ -0,0 +1,198 @@
+/*
+  ==============================================================================
+
+    PerformanceGate.cpp
+
+  ==============================================================================
+*/
+
+#include "PerformanceGate.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <numeric>
+
+namespace PerformanceGate
+{
+    double Result::getMedian() const
+    {
+        if (samples.empty())
+            return 0.0;
+
+        auto sorted = samples;
+        std::sort(sorted.begin(), sorted.end());
+
+        const auto middle = sorted.size() / 2;
+        return (sorted.size() % 2) != 0 ? sorted[middle] : 0.5 * (sorted[middle - 1] + sorted[middle]);
+    }
+
+    double Result::getMinimum() const
+    {
+        return samples.empty() ? 0.0 : *std::min_element(samples.begin(), samples.end());
+    }
+
+    double Result::getMaximum() const
+    {
+        return samples.empty() ? 0.0 : *std::max_element(samples.begin(), samples.end());
+    }
+
+    double Result::getStandardDeviation() const
+    {
+        if (samples.size() < 2)
+            return 0.0;
+
+        const auto mean = std::accumulate(samples.begin(), samples.end(), 0.0) / (double) samples.size();
+        auto sumOfSquares = 0.0;
+
+        for (auto sample : samples)
+            sumOfSquares += (sample - mean) * (sample - mean);
+
+        return std::sqrt(sumOfSquares / (double) (samples.size() - 1));
+    }
+
+    Result measure(const juce::String& name, const juce::String& unit, int repetitions,
+                   const std::function<double()>& measureOnce)
+    {
+        Result result;
+        result.name = name;
+        result.unit = unit;
+
+        measureOnce();
+
+        for (int i = 0; i < juce::jmax(1, repetitions); ++i)
+            result.samples.push_back(measureOnce());
+
+        return result;
+    }
+
+    juce::String getDefaultMachineID()
+    {
+        auto id = juce::SystemStats::getCpuModel() + " " + juce::String(juce::SystemStats::getNumCpus());
+
+        // Lower case, with every run of anything but letters and digits collapsed to a single '-':
+        juce::String legal;
+        bool lastWasSeparator = true;
+
+        for (auto character : id.toLowerCase())
+        {
+            if (juce::CharacterFunctions::isLetterOrDigit(character))
+            {
+                legal << juce::String::charToString(character);
+                lastWasSeparator = false;
+            }
+            else if (! lastWasSeparator)
+            {
+                legal << "-";
+                lastWasSeparator = true;
+            }
+        }
+
+        legal = legal.trimCharactersAtEnd("-");
+        return legal.isNotEmpty() ? legal : "unknown-machine";
+    }
+
+    juce::var toJSON(const std::vector<Result>& results, const juce::String& machineID, const juce::String& label)
+    {
+        juce::Array<juce::var> resultArray;
+
+        for (const auto& result : results)
+        {
+            juce::Array<juce::var> samples;
+            for (auto sample : result.samples)
+                samples.add(sample);
+
+            auto* object = new juce::DynamicObject();
+            object->setProperty("name", result.name);
+            object->setProperty("unit", result.unit);
+            object->setProperty("median", result.getMedian());
+            object->setProperty("min", result.getMinimum());
+            object->setProperty("max", result.getMaximum());
+            object->setProperty("stddev", result.getStandardDeviation());
+            object->setProperty("repetitions", (int) result.samples.size());
+            object->setProperty("samples", samples);
+
+            resultArray.add(juce::var(object));
+        }
+
+        auto* root = new juce::DynamicObject();
+        root->setProperty("machine", machineID);
+        root->setProperty("cpu", juce::SystemStats::getCpuModel());
+        root->setProperty("os", juce::SystemStats::getOperatingSystemName());
+        root->setProperty("timestamp", juce::Time::getCurrentTime().toISO8601(true));
+        root->setProperty("label", label);
+        root->setProperty("results", resultArray);
+
+        return juce::var(root);
+    }
+
+    bool writeJSON(const juce::File& file, const juce::var& json)
+    {
+        if (! file.getParentDirectory().createDirectory())
+            return false;
+
+        return file.replaceWithText(juce::JSON::toString(json) + "\n");
+    }
+
+    bool compareWithBaseline(const std::vector<Result>& results, const juce::File& baselineFile, double threshold)
+    {
+        if (! baselineFile.existsAsFile())
+        {
+            // A gate with nothing to compare against would pass anything:
+            std::cout << "No baseline at " << baselineFile.getFullPathName()
+                      << " (run with --update-baseline on this machine to create one)" << std::endl
+                      << "Performance gate: FAILED" << std::endl;
+            return false;
+        }
+
+        const auto baseline = juce::JSON::parse(baselineFile);
+
+        if (! baseline.isObject())
+        {
+            std::cout << "Couldn't parse baseline " << baselineFile.getFullPathName() << std::endl
+                      << "Performance gate: FAILED" << std::endl;
+            return false;
+        }
+
+        // name -> median:
+        std::map<juce::String, double> baselineMedians;
+
+        if (auto* baselineResults = baseline["results"].getArray())
+            for (const auto& result : *baselineResults)
+                baselineMedians[result["name"].toString()] = (double) result["median"];
+
+        std::cout << juce::String("benchmark").paddedRight(' ', 44) << "  baseline     current   change" << std::endl;
+
+        bool passed = true;
+
+        for (const auto& result : results)
+        {
+            const auto median = result.getMedian();
+            const auto baselineMedian = baselineMedians.find(result.name);
+
+            std::cout << result.name.paddedRight(' ', 44);
+
+            if (baselineMedian == baselineMedians.end() || baselineMedian->second <= 0.0)
+            {
+                std::cout << "         -" << juce::String(median, 3).paddedLeft(' ', 12) << "   (new)" << std::endl;
+                continue;
+            }
+
+            const auto change = median / baselineMedian->second - 1.0;
+            const bool isRegression = change > threshold;
+            passed &= ! isRegression;
+
+            std::cout << juce::String(baselineMedian->second, 3).paddedLeft(' ', 10)
+                      << juce::String(median, 3).paddedLeft(' ', 12)
+                      << (juce::String(change >= 0.0 ? "+" : "") + juce::String(change * 100.0, 1) + "%").paddedLeft(' ', 9)
+                      << (isRegression ? "  REGRESSION" : "")
+                      << "  " << result.unit << std::endl;
+        }
+
+        std::cout << "Performance gate (threshold +" << juce::String(threshold * 100.0, 1) << "%): "
+                  << (passed ? "passed" : "FAILED") << std::endl;
+
+        return passed;
+    }
+}
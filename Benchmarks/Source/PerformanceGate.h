@@ -0,0 +1,52 @@
+/*
+  ==============================================================================
+
+    PerformanceGate.h
+
+    Repeated measurement of hot paths, machine-readable (JSON) results, and
+    comparison against per-machine baselines stored in the repo
+    (Benchmarks/Baselines/<machine id>.json).
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <functional>
+#include <vector>
+
+namespace PerformanceGate
+{
+    // One metric of one hot path (lower is better), with a sample per repetition:
+    struct Result
+    {
+        juce::String name, unit;
+        std::vector<double> samples;
+
+        double getMedian() const;
+        double getMinimum() const;
+        double getMaximum() const;
+        double getStandardDeviation() const;
+    };
+
+    // Calls 'measureOnce' once to warm up, then 'repetitions' times, keeping what each call returns:
+    Result measure(const juce::String& name, const juce::String& unit, int repetitions,
+                   const std::function<double()>& measureOnce);
+
+    // e.g. "intel-r-core-tm-i7-9750h-cpu-2-60ghz-12": CPU model and core count, file-name safe:
+    juce::String getDefaultMachineID();
+
+    // { "machine", "cpu", "os", "timestamp", "label", "results": [ { "name", "unit", "median", "min", "max",
+    //   "stddev", "repetitions", "samples": [...] } ] }
+    juce::var toJSON(const std::vector<Result>& results, const juce::String& machineID, const juce::String& label);
+    bool writeJSON(const juce::File& file, const juce::var& json);
+
+    /**
+     Compares each result's median with the baseline's, printing a table. Returns false if any is slower
+     by more than 'threshold' (0.1 = 10%), or if there's no baseline file. Results missing from the
+     baseline only get reported.
+     */
+    bool compareWithBaseline(const std::vector<Result>& results, const juce::File& baselineFile, double threshold);
+}
@@ -0,0 +1,265 @@
+/*
+  ==============================================================================
+
+    RealtimeSafetyChecker.cpp
+
+  ==============================================================================
+*/
+
+#include "RealtimeSafetyChecker.h"
+
+// (GCC defines __SANITIZE_*__; clang only answers __has_feature)
+#if defined (__SANITIZE_ADDRESS__) || defined (__SANITIZE_THREAD__)
+ #define SIMPLEEQ_SANITIZER_BUILD 1
+#elif defined (__has_feature)
+ #if __has_feature (address_sanitizer) || __has_feature (thread_sanitizer)
+  #define SIMPLEEQ_SANITIZER_BUILD 1
+ #endif
+#endif
+
+#if JUCE_LINUX && ! defined (SIMPLEEQ_SANITIZER_BUILD)
+ #define SIMPLEEQ_CHECK_REALTIME_SAFETY 1
+#else
+ #define SIMPLEEQ_CHECK_REALTIME_SAFETY 0
+#endif
+
+#if SIMPLEEQ_CHECK_REALTIME_SAFETY
+
+#include <atomic>
+#include <cerrno>
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <new>
+#include <pthread.h>
+
+extern "C"
+{
+    void* __libc_malloc(size_t);
+    void* __libc_calloc(size_t, size_t);
+    void* __libc_realloc(void*, size_t);
+    void* __libc_memalign(size_t, size_t);
+    void __libc_free(void*);
+}
+
+namespace
+{
+    constexpr int maxFrames = 32;
+    constexpr int maxViolations = 64;
+
+    // Written from inside the interposed functions, so nothing here may allocate: fixed storage, claimed atomically.
+    struct RawViolation
+    {
+        const char* function;
+        void* frames[maxFrames];
+        int numFrames;
+    };
+
+    RawViolation rawViolations[maxViolations];
+    std::atomic<int> numRawViolations { 0 };
+    std::atomic<int> numDroppedViolations { 0 };
+
+    // (plain PODs, so accessing them never allocates either)
+    thread_local int checkDepth = 0;
+    thread_local bool isRecording = false;
+
+    void recordViolation(const char* function)
+    {
+        // Not checking, or already recording: backtrace() may allocate itself the first time round.
+        if (checkDepth == 0 || isRecording)
+            return;
+
+        isRecording = true;
+
+        const auto index = numRawViolations.fetch_add(1);
+
+        if (index < maxViolations)
+        {
+            auto& violation = rawViolations[index];
+            violation.function = function;
+            violation.numFrames = backtrace(violation.frames, maxFrames);
+        }
+        else
+        {
+            numDroppedViolations.fetch_add(1);
+        }
+
+        isRecording = false;
+    }
+
+    // "binary(mangled+0x12) [0x...]" -> "binary(demangled+0x12) [0x...]", when there's a symbol to demangle:
+    juce::String demangleFrame(const char* frame)
+    {
+        juce::String line(frame);
+
+        const auto start = line.indexOfChar('(') + 1;
+        const auto end = line.indexOfChar(start, '+');
+
+        if (start <= 0 || end <= start)
+            return line;
+
+        int status = 0;
+        auto* demangled = abi::__cxa_demangle(line.substring(start, end).toRawUTF8(), nullptr, nullptr, &status);
+
+        if (status != 0 || demangled == nullptr)
+            return line;
+
+        line = line.replaceSection(start, end - start, demangled);
+        ::free(demangled);
+        return line;
+    }
+
+    using MutexLockFunction = int (*)(pthread_mutex_t*);
+    MutexLockFunction realMutexLock = nullptr;
+}
+
+//==============================================================================
+extern "C"
+{
+    void* malloc(size_t size)
+    {
+        recordViolation("malloc");
+        return __libc_malloc(size);
+    }
+
+    void* calloc(size_t numElements, size_t size)
+    {
+        recordViolation("calloc");
+        return __libc_calloc(numElements, size);
+    }
+
+    void* realloc(void* pointer, size_t size)
+    {
+        recordViolation("realloc");
+        return __libc_realloc(pointer, size);
+    }
+
+    void free(void* pointer)
+    {
+        if (pointer != nullptr)
+            recordViolation("free");
+
+        __libc_free(pointer);
+    }
+
+    void* memalign(size_t alignment, size_t size)
+    {
+        recordViolation("memalign");
+        return __libc_memalign(alignment, size);
+    }
+
+    void* aligned_alloc(size_t alignment, size_t size)
+    {
+        recordViolation("aligned_alloc");
+        return __libc_memalign(alignment, size);
+    }
+
+    int posix_memalign(void** result, size_t alignment, size_t size)
+    {
+        recordViolation("posix_memalign");
+
+        if (alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0)
+            return EINVAL;
+
+        *result = __libc_memalign(alignment, size);
+        return *result != nullptr || size == 0 ? 0 : ENOMEM;
+    }
+
+    int pthread_mutex_lock(pthread_mutex_t* mutex)
+    {
+        // (resolved lazily: this can be called before static initialisation has got round to this file)
+        if (realMutexLock == nullptr)
+            realMutexLock = reinterpret_cast<MutexLockFunction>(dlsym(RTLD_NEXT, "pthread_mutex_lock"));
+
+        recordViolation("pthread_mutex_lock");
+        return realMutexLock(mutex);
+    }
+}
+
+//==============================================================================
+static void* allocate(size_t size, const char* function)
+{
+    recordViolation(function);
+
+    if (auto* pointer = __libc_malloc(size == 0 ? 1 : size))
+        return pointer;
+
+    throw std::bad_alloc();
+}
+
+static void deallocate(void* pointer, const char* function)
+{
+    if (pointer != nullptr)
+        recordViolation(function);
+
+    __libc_free(pointer);
+}
+
+void* operator new(size_t size)                                  { return allocate(size, "operator new"); }
+void* operator new[](size_t size)                                { return allocate(size, "operator new[]"); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept   { try { return allocate(size, "operator new"); } catch (...) { return nullptr; } }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { try { return allocate(size, "operator new[]"); } catch (...) { return nullptr; } }
+
+void operator delete(void* pointer) noexcept                              { deallocate(pointer, "operator delete"); }
+void operator delete[](void* pointer) noexcept                            { deallocate(pointer, "operator delete[]"); }
+void operator delete(void* pointer, size_t) noexcept                      { deallocate(pointer, "operator delete"); }
+void operator delete[](void* pointer, size_t) noexcept                    { deallocate(pointer, "operator delete[]"); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept       { deallocate(pointer, "operator delete"); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept     { deallocate(pointer, "operator delete[]"); }
+
+// (the aligned forms go through aligned_alloc()/free(), so are already covered)
+
+//==============================================================================
+namespace RealtimeSafetyChecker
+{
+    bool isSupported() { return true; }
+
+    ScopedCheck::ScopedCheck()  { ++checkDepth; }
+    ScopedCheck::~ScopedCheck() { --checkDepth; }
+
+    std::vector<Violation> takeViolations()
+    {
+        jassert(checkDepth == 0);
+
+        std::vector<Violation> violations;
+        const auto numRecorded = juce::jmin(numRawViolations.exchange(0), maxViolations);
+
+        for (int i = 0; i < numRecorded; ++i)
+        {
+            const auto& raw = rawViolations[i];
+
+            Violation violation;
+            violation.function = raw.function;
+
+            if (auto* symbols = backtrace_symbols(raw.frames, raw.numFrames))
+            {
+                // (skipping recordViolation() itself)
+                for (int frame = 1; frame < raw.numFrames; ++frame)
+                    violation.callStack.add(demangleFrame(symbols[frame]));
+
+                ::free(symbols);
+            }
+
+            violations.push_back(std::move(violation));
+        }
+
+        return violations;
+    }
+
+    int getNumDroppedViolations() { return numDroppedViolations.exchange(0); }
+}
+
+#else
+
+namespace RealtimeSafetyChecker
+{
+    bool isSupported() { return false; }
+
+    ScopedCheck::ScopedCheck() {}
+    ScopedCheck::~ScopedCheck() {}
+
+    std::vector<Violation> takeViolations() { return {}; }
+    int getNumDroppedViolations() { return 0; }
+}
+
+#endif
@@ -0,0 +1,47 @@
+/*
+  ==============================================================================
+
+    RealtimeSafetyChecker.h
+
+    Catches heap allocation/deallocation and mutex locking on a thread while
+    it's inside a RealtimeSafetyChecker::ScopedCheck (i.e. around an audio
+    callback), recording the call stack of every violation.
+
+    Works by interposing malloc & co., operator new/delete and
+    pthread_mutex_lock in this executable, so it's Linux (glibc) only, and is
+    switched off in sanitizer builds, which interpose the same functions.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <vector>
+
+namespace RealtimeSafetyChecker
+{
+    bool isSupported();
+
+    // Whatever the current thread does inside one of these is checked:
+    struct ScopedCheck
+    {
+        ScopedCheck();
+        ~ScopedCheck();
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedCheck)
+    };
+
+    struct Violation
+    {
+        juce::String function;          // "malloc", "operator new", "pthread_mutex_lock", ...
+        juce::StringArray callStack;    // innermost frame first
+    };
+
+    // Returns, and forgets, the violations recorded so far (call this outside any ScopedCheck):
+    std::vector<Violation> takeViolations();
+
+    // Violations beyond the fixed number there's room to record are only counted:
+    int getNumDroppedViolations();
+}
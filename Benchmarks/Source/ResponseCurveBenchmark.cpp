@@ -0,0 +1,142 @@
+/*
+  ==============================================================================
+
+    ResponseCurveBenchmark.cpp
+
+  ==============================================================================
+*/
+
+#include "ResponseCurveBenchmark.h"
+
+#include "../../Source/PluginProcessor.h"
+#include "../../Source/PluginEditor.h"
+
+#include <array>
+#include <cmath>
+
+ResponseCurveBenchmark::Result ResponseCurveBenchmark::run(const Config& config, int numFrames)
+{
+    using namespace juce;
+
+    constexpr int blockSize = 256;
+    constexpr int numWarmUpFrames = 16;
+
+    SimpleEQAudioProcessor processor;
+    processor.setRateAndBufferSizeDetails(config.sampleRate, blockSize);
+    processor.prepareToPlay(config.sampleRate, blockSize);
+
+    // (after prepareToPlay(), so the component sees the sample rate from the start)
+    ResponseCurveComponent component(processor);
+
+    Result result;
+
+    // Renders its images at the display's resolution, as it would after its first paint on such a display:
+    component.displayScale = config.scale;
+
+    const auto resizeStart = Time::getHighResolutionTicks();
+    component.setBounds(0, 0, config.width, config.height);
+    result.resizeMs = Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - resizeStart) * 1000.0;
+
+    // The analyser, stepped on this thread once per frame instead of being woken by the display:
+    component.analyzerRenderThread = std::make_unique<AnalyzerRenderThread>(processor);
+    auto& analyzer = *component.analyzerRenderThread;
+
+    // (the analyser's frames are rendered in physical pixels)
+    const auto analysisArea = component.getAnalysisArea();
+    const auto analysisWidth = roundToInt((float) analysisArea.getWidth() * config.scale);
+    const auto analysisHeight = roundToInt((float) analysisArea.getHeight() * config.scale);
+    const auto fftBounds = Rectangle<float>(0.f, 0.f, (float) analysisWidth, (float) analysisHeight);
+
+    Image frame(Image::ARGB,
+                roundToInt((float) config.width * config.scale),
+                roundToInt((float) config.height * config.scale),
+                true, SoftwareImageType());
+
+    // Synthetic input: noise plus a sine sweeping 100Hz-10kHz every 2s, a display frame's worth at a time:
+    AudioBuffer<float> buffer(2, blockSize);
+    MidiBuffer midi;
+    Random random(0x5eed);
+    double phase = 0.0;
+    double samplesDue = 0.0;
+
+    auto feedAudio = [&](int frameIndex)
+    {
+        const auto frequency = 100.0 * std::pow(100.0, (double) (frameIndex % 120) / 120.0);
+        const auto phaseIncrement = MathConstants<double>::twoPi * frequency / config.sampleRate;
+
+        for (samplesDue += config.sampleRate * LoadMeter::displayFrameSeconds; samplesDue >= blockSize; samplesDue -= blockSize)
+        {
+            for (int i = 0; i < blockSize; ++i)
+            {
+                const auto sample = 0.5f * (float) std::sin(phase) + 0.05f * (random.nextFloat() - 0.5f);
+                phase = std::fmod(phase + phaseIncrement, MathConstants<double>::twoPi);
+
+                buffer.setSample(0, i, sample);
+                buffer.setSample(1, i, sample);
+            }
+
+            processor.processBlock(buffer, midi);
+        }
+    };
+
+    std::array<int64, 5> ticks {};
+
+    auto timed = [&ticks](size_t stage, auto&& work)
+    {
+        const auto start = Time::getHighResolutionTicks();
+        work();
+        ticks[stage] += Time::getHighResolutionTicks() - start;
+    };
+
+    for (int frameIndex = 0; frameIndex < numWarmUpFrames + numFrames; ++frameIndex)
+    {
+        if (frameIndex == numWarmUpFrames)
+            ticks.fill(0);
+
+        feedAudio(frameIndex);
+
+        timed(0, [&]
+        {
+            component.updateLowCutMagnitudes();
+            component.updatePeakMagnitudes();
+            component.updateHighCutMagnitudes();
+            component.updateExtraBandMagnitudes();
+        });
+
+        timed(1, [&]
+        {
+            analyzer.leftPathProducer.process(fftBounds, config.sampleRate);
+            analyzer.rightPathProducer.process(fftBounds, config.sampleRate);
+        });
+
+        timed(2, [&] { component.updateResponseCurvePath(); });
+
+        timed(3, [&]
+        {
+            component.strokeResponseCurve();
+            analyzer.renderFrame(analysisWidth, analysisHeight, config.scale, analyzer.leftPathProducer.getFrameStamp());
+        });
+
+        timed(4, [&]
+        {
+            Graphics g(frame);
+            g.addTransform(AffineTransform::scale(config.scale));
+            component.paintEntireComponent(g, true);
+        });
+    }
+
+    auto toMicrosecondsPerFrame = [numFrames](int64 total)
+    {
+        return Time::highResolutionTicksToSeconds(total) * 1.0e6 / jmax(1, numFrames);
+    };
+
+    result.magnitudes = toMicrosecondsPerFrame(ticks[0]);
+    result.analyserPaths = toMicrosecondsPerFrame(ticks[1]);
+    result.curvePath = toMicrosecondsPerFrame(ticks[2]);
+    result.stroking = toMicrosecondsPerFrame(ticks[3]);
+    result.paint = toMicrosecondsPerFrame(ticks[4]);
+
+    processor.releaseResources();
+
+    return result;
+}
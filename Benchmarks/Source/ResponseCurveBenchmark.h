@@ -0,0 +1,51 @@
+/*
+  ==============================================================================
+
+    ResponseCurveBenchmark.h
+
+    Headless frame-time benchmark of ResponseCurveComponent: a processor is
+    fed synthetic audio, and the component is laid out and painted into an
+    offscreen image, frame after frame, with no window or display involved.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+struct ResponseCurveBenchmark
+{
+    struct Config
+    {
+        int width = 480, height = 117;      // (the size the editor gives it by default)
+        float scale = 1.f;                  // display scale factor the frame is painted at
+        double sampleRate = 48000.0;
+    };
+
+    // Mean time per frame (us) of each stage:
+    struct Result
+    {
+        // The three bands' magnitudes over the frequency grid (as after any parameter change):
+        double magnitudes = 0.0;
+
+        // FFT analysis of the new audio, and both channels' analyser paths:
+        double analyserPaths = 0.0;
+
+        // The response curve's path, from the magnitudes:
+        double curvePath = 0.0;
+
+        // Stroking the response curve, and rasterising the analyser paths into their image:
+        double stroking = 0.0;
+
+        // Compositing the cached images into the frame (paint()):
+        double paint = 0.0;
+
+        double getTotal() const { return magnitudes + analyserPaths + curvePath + stroking + paint; }
+
+        // One-off: laying the component out at this size (resized(): grid, labels, frequency grid, curve), in ms:
+        double resizeMs = 0.0;
+    };
+
+    static Result run(const Config& config, int numFrames);
+};
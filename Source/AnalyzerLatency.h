@@ -0,0 +1,115 @@
+/*
+  ==============================================================================
+
+    AnalyzerLatency.h
+
+    Stamps analyser frames with the sample position and time they were
+    captured at, and records how stale they are at each stage on their way
+    to the screen.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include "LoadMeter.h"
+
+#include <array>
+
+// Identifies the newest audio in an analyser frame:
+struct FrameStamp
+{
+    // Samples pushed through the SingleChannelSampleFifo since it was prepared, up to and including this one:
+    juce::int64 samplePosition = -1;
+
+    // Time::getHighResolutionTicks() when the audio thread pushed the buffer holding it:
+    juce::int64 captureTicks = 0;
+
+    bool isValid() const { return samplePosition >= 0; }
+};
+
+/**
+ Latency distributions, from capture on the audio thread, for each stage an analyser frame goes through.
+ Each stage is recorded by one thread only (see Stage), so this is as lock-free as LoadMeter, which it's built on.
+ */
+class AnalyzerLatency
+{
+public:
+    enum Stage
+    {
+        Dequeued,   // pulled off the SingleChannelSampleFifo by the analyser thread
+        Analysed,   // FFT done and path generated (analyser thread)
+        Rendered,   // rasterised into the back image (analyser thread)
+        PickedUp,   // seen by the next vblank on the message thread
+        Painted,    // first drawn by paint() (message thread)
+
+        numStages
+    };
+
+    static const char* getStageName(Stage stage)
+    {
+        static const char* const names[] { "Dequeued", "Analysed", "Rendered", "Picked up", "Painted" };
+        return names[stage];
+    }
+
+    struct Stats
+    {
+        double lastMs = 0.0, meanMs = 0.0, p50Ms = 0.0, p90Ms = 0.0, p99Ms = 0.0, worstMs = 0.0;
+        juce::uint64 numFrames = 0;
+    };
+
+    void record(Stage stage, const FrameStamp& stamp, juce::int64 nowTicks = juce::Time::getHighResolutionTicks())
+    {
+        if (! stamp.isValid())
+            return;
+
+        stages[(size_t) stage].addMeasurement(juce::Time::highResolutionTicksToSeconds(nowTicks - stamp.captureTicks), histogramScaleSeconds);
+
+        if (stage == Painted)
+        {
+            lastPaintedSamplePosition.store(stamp.samplePosition, std::memory_order_relaxed);
+            lastPaintedCaptureTicks.store(stamp.captureTicks, std::memory_order_relaxed);
+        }
+    }
+
+    Stats getStats(Stage stage) const
+    {
+        const auto& meter = stages[(size_t) stage];
+        const auto loadStats = meter.getStats();
+        const auto toMs = histogramScaleSeconds * 1000.0;
+
+        Stats stats;
+        stats.lastMs = loadStats.last * toMs;
+        stats.meanMs = loadStats.mean * toMs;
+        stats.p50Ms = meter.getPercentile(0.5) * toMs;
+        stats.p90Ms = meter.getPercentile(0.9) * toMs;
+        stats.p99Ms = loadStats.p99 * toMs;
+        stats.worstMs = loadStats.worst * toMs;
+        stats.numFrames = loadStats.numMeasurements;
+
+        return stats;
+    }
+
+    // The stamp of the frame most recently painted, to line the display up with the audio:
+    FrameStamp getLastPaintedFrame() const
+    {
+        return { lastPaintedSamplePosition.load(std::memory_order_relaxed), lastPaintedCaptureTicks.load(std::memory_order_relaxed) };
+    }
+
+    // Takes effect at each stage's next frame:
+    void reset()
+    {
+        for (auto& stage : stages)
+            stage.reset();
+    }
+
+private:
+    // LoadMeter's histogram spans 2x its budget in 1% bins, so this gives 2.5 ms bins up to 500 ms
+    // (worst and mean are exact):
+    static constexpr double histogramScaleSeconds = 0.25;
+
+    std::array<LoadMeter, numStages> stages;
+    std::atomic<juce::int64> lastPaintedSamplePosition { -1 }, lastPaintedCaptureTicks { 0 };
+};
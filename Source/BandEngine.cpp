@@ -0,0 +1,217 @@
+/*
+  ==============================================================================
+
+    BandEngine.cpp
+
+  ==============================================================================
+*/
+
+#include "BandEngine.h"
+
+//==============================================================================
+void BandEngine::prepare(double newSampleRate, int newNumChannels)
+{
+    jassert(newNumChannels <= maxChannels);
+
+    sampleRate = newSampleRate;
+    numChannels = juce::jmin(newNumChannels, maxChannels);
+
+    // (sections set from outside were designed for the old rate, so every band goes back to its settings)
+    hasExternalSections.fill(false);
+
+    for (int i = 0; i < maxBands; ++i)
+        designBand(i);
+
+    rebuildCascade();
+    reset();
+}
+
+void BandEngine::reset()
+{
+    for (auto& channelState : state)
+        for (auto& sectionState : channelState)
+            sectionState = { 0.f, 0.f };
+}
+
+void BandEngine::setBand(int index, const BandSettings& settings)
+{
+    jassert(juce::isPositiveAndBelow(index, maxBands));
+
+    auto& band = bands[(size_t) index];
+
+    if (band == settings && ! hasExternalSections[(size_t) index])
+        return;
+
+    const auto previousNumSections = numBandSections[(size_t) index];
+
+    band = settings;
+    hasExternalSections[(size_t) index] = false;
+    designBand(index);
+
+    updateCascade(index, previousNumSections);
+}
+
+void BandEngine::setBandSections(int index, const SectionDesign::Section* sections, int numSections)
+{
+    jassert(juce::isPositiveAndBelow(index, maxBands) && numSections <= maxSectionsPerBand);
+
+    const auto previousNumSections = numBandSections[(size_t) index];
+    auto& bandSection = bandSections[(size_t) index];
+    auto& numSectionsUsed = numBandSections[(size_t) index];
+
+    numSectionsUsed = 0;
+
+    for (int i = 0; i < juce::jmin(numSections, maxSectionsPerBand); ++i)
+        if (sections[i] != SectionDesign::unity)
+            bandSection[(size_t) numSectionsUsed++] = sections[i];
+
+    hasExternalSections[(size_t) index] = true;
+
+    updateCascade(index, previousNumSections);
+}
+
+void BandEngine::updateCascade(int index, int previousNumSections)
+{
+    const auto numSections = numBandSections[(size_t) index];
+
+    // A band coming back on starts from silence, not from whatever it held when it was switched off:
+    if (previousNumSections == 0 && numSections > 0)
+        resetBandState(index);
+
+    if (numSections != previousNumSections)
+    {
+        rebuildCascade();
+        return;
+    }
+
+    // Same sections, new coefficients: update them where they sit in the cascade.
+    for (int i = 0; i < numActiveSections; ++i)
+        if (activeStateIndices[(size_t) i] / maxSectionsPerBand == index)
+            activeSections[(size_t) i] = bandSections[(size_t) index][(size_t) (activeStateIndices[(size_t) i] % maxSectionsPerBand)];
+}
+
+void BandEngine::designBand(int index)
+{
+    const auto& band = bands[(size_t) index];
+    auto& sections = bandSections[(size_t) index];
+    auto& numSections = numBandSections[(size_t) index];
+
+    numSections = 0;
+
+    if (! band.enabled || sampleRate <= 0.0)
+        return;
+
+    const auto gainFactor = juce::Decibels::decibelsToGain(band.gainInDecibels);
+
+    switch (band.type)
+    {
+        case BandType::Bell:
+            SectionDesign::designPeak(band.frequency, band.quality, gainFactor, sampleRate, sections[0]);
+            numSections = 1;
+            break;
+
+        case BandType::LowShelf:
+            SectionDesign::designLowShelf(band.frequency, band.quality, gainFactor, sampleRate, sections[0]);
+            numSections = 1;
+            break;
+
+        case BandType::HighShelf:
+            SectionDesign::designHighShelf(band.frequency, band.quality, gainFactor, sampleRate, sections[0]);
+            numSections = 1;
+            break;
+
+        case BandType::LowCut:
+        case BandType::HighCut:
+        {
+            const auto order = juce::jlimit(1, maxSectionsPerBand, band.cutOrder / 2) * 2;
+            SectionDesign::designButterworth(band.type == BandType::LowCut, band.frequency, order, sampleRate, sections.data());
+            numSections = order / 2;
+            break;
+        }
+    }
+}
+
+void BandEngine::rebuildCascade()
+{
+    numActiveSections = 0;
+
+    for (int band = 0; band < maxBands; ++band)
+        for (int section = 0; section < numBandSections[(size_t) band]; ++section)
+        {
+            activeSections[(size_t) numActiveSections] = bandSections[(size_t) band][(size_t) section];
+            activeStateIndices[(size_t) numActiveSections] = band * maxSectionsPerBand + section;
+            ++numActiveSections;
+        }
+}
+
+void BandEngine::resetBandState(int index)
+{
+    for (auto& channelState : state)
+        for (int section = 0; section < maxSectionsPerBand; ++section)
+            channelState[(size_t) (index * maxSectionsPerBand + section)] = { 0.f, 0.f };
+}
+
+void BandEngine::process(const juce::dsp::ProcessContextReplacing<float>& context)
+{
+    auto& block = context.getOutputBlock();
+    const auto numSamples = (int) block.getNumSamples();
+    const auto channelsToProcess = juce::jmin(numChannels, (int) block.getNumChannels());
+
+    for (int channel = 0; channel < channelsToProcess; ++channel)
+    {
+        auto* samples = block.getChannelPointer((size_t) channel);
+        auto& channelState = state[(size_t) channel];
+
+        // One section at a time over the whole block, with its coefficients and state in registers:
+        for (int i = 0; i < numActiveSections; ++i)
+        {
+            const auto& c = activeSections[(size_t) i];
+            const auto b0 = c[0], b1 = c[1], b2 = c[2], a1 = c[3], a2 = c[4];
+
+            auto& sectionState = channelState[(size_t) activeStateIndices[(size_t) i]];
+            auto s1 = sectionState[0], s2 = sectionState[1];
+
+            for (int n = 0; n < numSamples; ++n)
+            {
+                const auto input = samples[n];
+                const auto output = b0 * input + s1;
+
+                s1 = b1 * input - a1 * output + s2;
+                s2 = b2 * input - a2 * output;
+                samples[n] = output;
+            }
+
+            // (as IIR::Filter does after each block)
+            juce::dsp::util::snapToZero(s1);
+            juce::dsp::util::snapToZero(s2);
+
+            sectionState = { s1, s2 };
+        }
+    }
+}
+
+void BandEngine::multiplyMagnitudes(BiquadMagnitudeEvaluator& evaluator, double* magnitudes) const
+{
+    for (int index = 0; index < maxBands; ++index)
+    {
+        const auto& band = bands[(size_t) index];
+        const auto numSections = numBandSections[(size_t) index];
+
+        if (numSections == 0)
+            continue;
+
+        // A whole cut in one pass, in closed form, where the sections really behave like one:
+        if ((band.type == BandType::LowCut || band.type == BandType::HighCut) && ! hasExternalSections[(size_t) index]
+            && band.frequency / evaluator.getSampleRate() >= BiquadMagnitudeEvaluator::minButterworthCutoffRatio)
+        {
+            evaluator.multiplyButterworthMagnitudes(band.type == BandType::LowCut, band.frequency, numSections * 2, magnitudes);
+            continue;
+        }
+
+        for (int i = 0; i < numSections; ++i)
+        {
+            const auto& c = bandSections[(size_t) index][(size_t) i];
+            evaluator.multiplyMagnitudes(c[0], c[1], c[2], c[3], c[4], magnitudes);
+        }
+    }
+}
@@ -0,0 +1,117 @@
+/*
+  ==============================================================================
+
+    BandEngine.h
+
+    An equaliser with any number of bands (up to maxBands), each a bell,
+    shelf or Butterworth cut, that can be switched off at no runtime cost.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "MagnitudeResponse.h"
+#include "SectionDesign.h"
+
+#include <array>
+
+enum class BandType
+{
+    Bell,
+    LowShelf,
+    HighShelf,
+    LowCut,
+    HighCut
+};
+
+struct BandSettings
+{
+    BandType type = BandType::Bell;
+    float frequency = 1000.f, gainInDecibels = 0.f, quality = 1.f;
+
+    // Cuts only: 2, 4, 6 or 8 (12 to 48 dB/Oct):
+    int cutOrder = 2;
+
+    bool enabled = false;
+
+    bool operator== (const BandSettings& other) const
+    {
+        return type == other.type && frequency == other.frequency && gainInDecibels == other.gainInDecibels
+            && quality == other.quality && cutOrder == other.cutOrder && enabled == other.enabled;
+    }
+
+    bool operator!= (const BandSettings& other) const { return ! operator== (other); }
+};
+
+/**
+ Every enabled band's sections are gathered into one flat cascade, rebuilt whenever a band changes,
+ so process() only ever touches the sections that do something: a disabled band costs nothing, a
+ bell or shelf costs one section, and a cut one per 12 dB/Oct.
+
+ SimpleEQAudioProcessor's filters: bands 0 to 2 are its low cut, peak and high cut (ChainPositions),
+ the rest its extra bands.
+
+ Not thread-safe: call setBand() from the thread that calls process() (at the start of a block, say),
+ as SimpleEQAudioProcessor does with its parameters. Neither allocates.
+ */
+class BandEngine
+{
+public:
+    static constexpr int maxBands = 16;
+    static constexpr int maxSectionsPerBand = 4;
+    static constexpr int maxChannels = 2;
+
+    void prepare(double sampleRate, int numChannels);
+
+    // Clears the filters' state:
+    void reset();
+
+    // Redesigns the band (only if its settings changed):
+    void setBand(int index, const BandSettings& settings);
+    const BandSettings& getBand(int index) const { return bands[(size_t) index]; }
+
+    // Runs the band with sections designed elsewhere (a preset slot's, or a blend of two designs) until the
+    // next setBand() redesigns it, whatever that's given. Unity sections are left out:
+    void setBandSections(int index, const SectionDesign::Section* sections, int numSections);
+
+    int getNumActiveSections() const { return numActiveSections; }
+
+    // In place, on up to maxChannels channels (the number prepared):
+    void process(const juce::dsp::ProcessContextReplacing<float>& context);
+
+    /** Multiplies 'magnitudes' (over the evaluator's grid) by the response of every enabled band. */
+    void multiplyMagnitudes(BiquadMagnitudeEvaluator& evaluator, double* magnitudes) const;
+
+private:
+    static constexpr int maxSections = maxBands * maxSectionsPerBand;
+
+    double sampleRate = 0.0;
+    int numChannels = 0;
+
+    std::array<BandSettings, maxBands> bands;
+
+    // Each band's designed sections:
+    std::array<std::array<SectionDesign::Section, maxSectionsPerBand>, maxBands> bandSections;
+    std::array<int, maxBands> numBandSections {};
+
+    // Bands running setBandSections()' sections rather than their settings' design:
+    std::array<bool, maxBands> hasExternalSections {};
+
+    // The cascade process() runs: the enabled bands' sections in band order, and where each one keeps its state
+    // (indexed by band and section, so a band's state survives other bands coming and going):
+    std::array<SectionDesign::Section, maxSections> activeSections;
+    std::array<int, maxSections> activeStateIndices {};
+    int numActiveSections = 0;
+
+    // Transposed direct form II state (two per section), per channel:
+    std::array<std::array<std::array<float, 2>, maxSections>, maxChannels> state {};
+
+    void designBand(int index);
+
+    // After the band's sections changed, from 'previousNumSections' of them:
+    void updateCascade(int index, int previousNumSections);
+    void rebuildCascade();
+    void resetBandState(int index);
+};
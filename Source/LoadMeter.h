@@ -0,0 +1,145 @@
+/*
+  ==============================================================================
+
+    LoadMeter.h
+
+    Lock-free timing statistics (last, mean, p99, worst) of a repeated piece
+    of work, as a fraction of the time available for it.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <array>
+#include <atomic>
+#include <cmath>
+
+/**
+ Collects how long each run of some work took relative to its budget (e.g. a block's duration), so
+ 1.0 means the deadline was only just met.
+
+ One thread at a time adds measurements (the audio thread, say), and any thread can read the stats.
+ Everything is relaxed atomics: no locks, no allocation, so it's fine to use from the audio thread.
+ */
+class LoadMeter
+{
+public:
+    struct Stats
+    {
+        double last = 0.0, mean = 0.0, p99 = 0.0, worst = 0.0;
+        juce::uint64 numMeasurements = 0;
+    };
+
+    // The budget for work done once per display refresh (analyser, paint):
+    static constexpr double displayFrameSeconds = 1.0 / 60.0;
+
+    // Measures the lifetime of this object:
+    struct ScopedMeasurement
+    {
+        ScopedMeasurement(LoadMeter& meterToUse, double budgetSeconds)
+            : meter(meterToUse), budget(budgetSeconds), startTicks(juce::Time::getHighResolutionTicks()) {}
+
+        ~ScopedMeasurement()
+        {
+            meter.addMeasurement(juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks), budget);
+        }
+
+        LoadMeter& meter;
+        const double budget;
+        const juce::int64 startTicks;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedMeasurement)
+    };
+
+    void addMeasurement(double elapsedSeconds, double budgetSeconds)
+    {
+        if (budgetSeconds <= 0.0)
+            return;
+
+        // Resets happen here, on the measuring thread, so the two never race:
+        if (resetRequested.exchange(false, std::memory_order_relaxed))
+            clear();
+
+        const auto load = elapsedSeconds / budgetSeconds;
+
+        // (only ever one writer, so these read-modify-write sequences needn't be atomic as a whole)
+        last.store(load, std::memory_order_relaxed);
+        sum.store(sum.load(std::memory_order_relaxed) + load, std::memory_order_relaxed);
+        count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+        if (load > worst.load(std::memory_order_relaxed))
+            worst.store(load, std::memory_order_relaxed);
+
+        auto& bin = histogram[(size_t) juce::jlimit(0, numBins - 1, (int) (load * binsPerUnit))];
+        bin.store(bin.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    Stats getStats() const
+    {
+        Stats stats;
+        stats.last = last.load(std::memory_order_relaxed);
+        stats.worst = worst.load(std::memory_order_relaxed);
+        stats.numMeasurements = count.load(std::memory_order_relaxed);
+
+        if (stats.numMeasurements == 0)
+            return stats;
+
+        stats.mean = sum.load(std::memory_order_relaxed) / (double) stats.numMeasurements;
+        stats.p99 = getPercentile(0.99);
+
+        return stats;
+    }
+
+    // Accurate to a histogram bin (1% of the budget); anything over 2x the budget counts as 2x here:
+    double getPercentile(double fraction) const
+    {
+        std::array<juce::uint32, numBins> counts;
+        juce::uint64 total = 0;
+
+        for (size_t i = 0; i < counts.size(); ++i)
+            total += (counts[i] = histogram[i].load(std::memory_order_relaxed));
+
+        if (total == 0)
+            return 0.0;
+
+        const auto target = juce::jmax((juce::uint64) 1, (juce::uint64) std::ceil(fraction * (double) total));
+        juce::uint64 cumulative = 0;
+
+        for (size_t i = 0; i < counts.size(); ++i)
+        {
+            cumulative += counts[i];
+
+            // (the upper edge of the bin, but never more than the worst case actually seen)
+            if (cumulative >= target)
+                return juce::jmin(worst.load(std::memory_order_relaxed), (double) (i + 1) / binsPerUnit);
+        }
+
+        return worst.load(std::memory_order_relaxed);
+    }
+
+    // Takes effect at the next measurement:
+    void reset() { resetRequested.store(true, std::memory_order_relaxed); }
+
+private:
+    static constexpr int binsPerUnit = 100;
+    static constexpr int numBins = 2 * binsPerUnit;
+
+    std::atomic<double> last { 0.0 }, sum { 0.0 }, worst { 0.0 };
+    std::atomic<juce::uint64> count { 0 };
+    std::array<std::atomic<juce::uint32>, numBins> histogram {};
+    std::atomic<bool> resetRequested { false };
+
+    void clear()
+    {
+        last.store(0.0, std::memory_order_relaxed);
+        sum.store(0.0, std::memory_order_relaxed);
+        worst.store(0.0, std::memory_order_relaxed);
+        count.store(0, std::memory_order_relaxed);
+
+        for (auto& bin : histogram)
+            bin.store(0, std::memory_order_relaxed);
+    }
+};
@@ -0,0 +1,152 @@
+/*
+  ==============================================================================
+
+    MagnitudeResponse.cpp
+
+  ==============================================================================
+*/
+
+#include "MagnitudeResponse.h"
+
+#if JUCE_USE_SIMD
+using SIMDDouble = juce::dsp::SIMDRegister<double>;
+static constexpr int numLanes = (int) SIMDDouble::SIMDNumElements;
+static constexpr int alignmentInDoubles = (int) (SIMDDouble::SIMDRegisterSize / sizeof(double));
+#else
+static constexpr int numLanes = 1;
+static constexpr int alignmentInDoubles = 1;
+#endif
+
+void BiquadMagnitudeEvaluator::prepare(int numPoints, double sampleRate, double minFrequency, double maxFrequency)
+{
+    numGridPoints = juce::jmax(0, numPoints);
+    gridSampleRate = sampleRate;
+    
+    // Round up to a whole number of SIMD registers, so that every array below starts aligned:
+    numPaddedPoints = ((numGridPoints + numLanes - 1) / numLanes) * numLanes;
+    
+    constexpr int numArrays = 8;
+    storage.assign((size_t) (numArrays * numPaddedPoints + alignmentInDoubles), 0.0);
+    
+    auto* ptr = storage.data();
+   #if JUCE_USE_SIMD
+    ptr = SIMDDouble::getNextSIMDAlignedPtr(ptr);
+   #endif
+    
+    frequencies = ptr;      ptr += numPaddedPoints;
+    prewarped = ptr;        ptr += numPaddedPoints;
+    cos1 = ptr;             ptr += numPaddedPoints;
+    sin1 = ptr;             ptr += numPaddedPoints;
+    cos2 = ptr;             ptr += numPaddedPoints;
+    sin2 = ptr;             ptr += numPaddedPoints;
+    numeratorPower = ptr;   ptr += numPaddedPoints;
+    denominatorPower = ptr;
+    
+    if (numGridPoints == 0)
+        return;
+    
+    for (int i = 0; i < numPaddedPoints; ++i)
+    {
+        // Padding repeats the last point, so the extra lanes stay finite:
+        auto x = juce::jmin(i, numGridPoints - 1);
+        
+        // Convert from pixels to Hz, then to radians/sample:
+        auto freq = juce::mapToLog10(double(x) / double(numGridPoints), minFrequency, maxFrequency);
+        auto w = juce::MathConstants<double>::twoPi * freq / sampleRate;
+        
+        frequencies[i] = freq;
+        // Above Nyquist the response mirrors, just as e^jw does:
+        prewarped[i] = std::abs(std::tan(0.5 * w));
+        cos1[i] = std::cos(w);
+        sin1[i] = std::sin(w);
+        cos2[i] = std::cos(2.0 * w);
+        sin2[i] = std::sin(2.0 * w);
+    }
+}
+
+void BiquadMagnitudeEvaluator::multiplyMagnitudes(const juce::dsp::IIR::Coefficients<float>& coefficients, double* magnitudes)
+{
+    // Coefficients are stored as b0, b1, [b2,] a1, [a2], normalised so that a0 == 1:
+    const auto* c = coefficients.coefficients.begin();
+    double b0 = 0, b1 = 0, b2 = 0, a1 = 0, a2 = 0;
+    
+    switch (coefficients.getFilterOrder())
+    {
+        case 1:
+            b0 = c[0]; b1 = c[1];
+            a1 = c[2];
+            break;
+            
+        case 2:
+            b0 = c[0]; b1 = c[1]; b2 = c[2];
+            a1 = c[3]; a2 = c[4];
+            break;
+            
+        default:
+            jassertfalse; // only first and second order sections are supported
+            return;
+    }
+    
+    multiplyMagnitudes(b0, b1, b2, a1, a2, magnitudes);
+}
+
+void BiquadMagnitudeEvaluator::multiplyMagnitudes(double b0, double b1, double b2, double a1, double a2, double* magnitudes)
+{
+    // |H|^2 = |b0 + b1 e^-jw + b2 e^-2jw|^2 / |1 + a1 e^-jw + a2 e^-2jw|^2
+   #if JUCE_USE_SIMD
+    const auto B0 = SIMDDouble::expand(b0), B1 = SIMDDouble::expand(b1), B2 = SIMDDouble::expand(b2);
+    const auto A1 = SIMDDouble::expand(a1), A2 = SIMDDouble::expand(a2);
+    const auto one = SIMDDouble::expand(1.0);
+    
+    for (int i = 0; i < numPaddedPoints; i += numLanes)
+    {
+        auto c1 = SIMDDouble::fromRawArray(cos1 + i);
+        auto s1 = SIMDDouble::fromRawArray(sin1 + i);
+        auto c2 = SIMDDouble::fromRawArray(cos2 + i);
+        auto s2 = SIMDDouble::fromRawArray(sin2 + i);
+        
+        auto numRe = B0 + B1 * c1 + B2 * c2;
+        auto numIm = B1 * s1 + B2 * s2;
+        auto denRe = one + A1 * c1 + A2 * c2;
+        auto denIm = A1 * s1 + A2 * s2;
+        
+        (numRe * numRe + numIm * numIm).copyToRawArray(numeratorPower + i);
+        (denRe * denRe + denIm * denIm).copyToRawArray(denominatorPower + i);
+    }
+   #else
+    for (int i = 0; i < numPaddedPoints; ++i)
+    {
+        auto numRe = b0 + b1 * cos1[i] + b2 * cos2[i];
+        auto numIm = b1 * sin1[i] + b2 * sin2[i];
+        auto denRe = 1.0 + a1 * cos1[i] + a2 * cos2[i];
+        auto denIm = a1 * sin1[i] + a2 * sin2[i];
+        
+        numeratorPower[i] = numRe * numRe + numIm * numIm;
+        denominatorPower[i] = denRe * denRe + denIm * denIm;
+    }
+   #endif
+    
+    for (int i = 0; i < numGridPoints; ++i)
+        magnitudes[i] *= std::sqrt(numeratorPower[i] / denominatorPower[i]);
+}
+
+void BiquadMagnitudeEvaluator::multiplyButterworthMagnitudes(bool isHighPass, double cutoffFrequency, int order, double* magnitudes) const
+{
+    jassert(order > 0);
+    
+    const auto prewarpedCutoff = std::tan(juce::MathConstants<double>::pi * cutoffFrequency / gridSampleRate);
+    
+    for (int i = 0; i < numGridPoints; ++i)
+    {
+        // ratio = t / tc for a low-pass, tc / t for a high-pass:
+        auto ratio = isHighPass ? prewarpedCutoff / prewarped[i] : prewarped[i] / prewarpedCutoff;
+        auto ratioSquared = ratio * ratio;
+        
+        // (ratio^2)^N without calling pow(); the order is at most 8:
+        auto power = 1.0;
+        for (int n = 0; n < order; ++n)
+            power *= ratioSquared;
+        
+        magnitudes[i] *= 1.0 / std::sqrt(1.0 + power);
+    }
+}
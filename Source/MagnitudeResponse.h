@@ -0,0 +1,84 @@
+/*
+  ==============================================================================
+
+    MagnitudeResponse.h
+
+    Batch evaluation of biquad magnitude responses over a fixed, log-spaced
+    frequency grid (one point per pixel column of the response curve).
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <vector>
+
+/**
+ Evaluates |H(e^jw)| of IIR filter sections (first or second order) at every point of a
+ log-spaced frequency grid.
+
+ The cos/sin terms of the grid are computed once in prepare(), which only needs calling again
+ when the number of points (i.e. the width of the analysis area) or the sample rate changes.
+ Evaluation then needs no trigonometry and runs on juce::dsp::SIMDRegister lanes.
+ */
+class BiquadMagnitudeEvaluator
+{
+public:
+    BiquadMagnitudeEvaluator() = default;
+
+    void prepare(int numPoints, double sampleRate, double minFrequency = 20.0, double maxFrequency = 20000.0);
+
+    bool isPreparedFor(int numPoints, double sampleRate) const
+    {
+        return numPoints == numGridPoints && sampleRate == gridSampleRate;
+    }
+
+    int getNumPoints() const { return numGridPoints; }
+    double getSampleRate() const { return gridSampleRate; }
+
+    // Frequency (Hz) of each grid point:
+    const double* getFrequencies() const { return frequencies; }
+
+    /** Multiplies each of the getNumPoints() entries of 'magnitudes' by the magnitude of the given section. */
+    void multiplyMagnitudes(const juce::dsp::IIR::Coefficients<float>& coefficients, double* magnitudes);
+
+    /** The same, for a second order section given as raw coefficients, normalised so that a0 == 1. */
+    void multiplyMagnitudes(double b0, double b1, double b2, double a1, double a2, double* magnitudes);
+
+    /**
+     Multiplies 'magnitudes' by the magnitude of a whole Butterworth cascade of the given order, as designed by
+     juce::dsp::FilterDesign's ...HighOrderButterworthMethod (bilinear transform with prewarping):
+
+         |H|^2 = 1 / (1 + (t / tc)^2N) for a low-pass, 1 / (1 + (tc / t)^2N) for a high-pass,
+
+     with t = tan(pi * f / fs), tc = tan(pi * cutoff / fs).
+     */
+    void multiplyButterworthMagnitudes(bool isHighPass, double cutoffFrequency, int order, double* magnitudes) const;
+
+    // Below this cutoff (as a fraction of the sample rate) float sections' poles sit so close to z = 1 that
+    // rounding moves them, and the filters stray from the ideal Butterworth response (by over 1 dB at 20 Hz and
+    // 192 kHz), so the closed form above no longer describes them. Above it they agree to within 0.03 dB at every
+    // slope:
+    static constexpr double minButterworthCutoffRatio = 0.002;
+
+private:
+    int numGridPoints = 0, numPaddedPoints = 0;
+    double gridSampleRate = 0.0;
+
+    // All arrays live in 'storage' and start SIMD-aligned, padded to a whole number of registers:
+    std::vector<double> storage;
+    double* frequencies = nullptr;
+    double* prewarped = nullptr;     // tan(pi * f / fs)
+    double* cos1 = nullptr;
+    double* sin1 = nullptr;
+    double* cos2 = nullptr;
+    double* sin2 = nullptr;
+
+    // Scratch for the squared numerator/denominator magnitudes:
+    double* numeratorPower = nullptr;
+    double* denominatorPower = nullptr;
+
+    JUCE_DECLARE_NON_COPYABLE (BiquadMagnitudeEvaluator)
+};
@@ -0,0 +1,253 @@
+/*
+  ==============================================================================
+
+    Parameters.h
+
+    The plugin's parameter set, described once at compile time (IDs, ranges,
+    types), and typed handles to the parameters resolved once per processor.
+    The fixed parameters come first, then each extra band's.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "BandEngine.h"
+
+#include <array>
+#include <atomic>
+
+namespace Parameters
+{
+    // Index of each parameter: the fixed ones, in the order of the table below, then the extra bands' (see
+    // getBandParameter()). Also the order they're added to the layout in. (An int underneath, as the extra bands'
+    // indices lie past the named ones.)
+    enum Index : int
+    {
+        LowCutFreq,
+        HighCutFreq,
+        PeakFreq,
+        PeakGain,
+        PeakQuality,
+        LowCutBypassed,
+        HighCutBypassed,
+        PeakBypassed,
+        AnalyserEnabled,
+        LowCutSlope,
+        HighCutSlope,
+        SvfTopology,
+
+        NumFixedParameters
+    };
+
+    // BandEngine's bands after the fixed low cut, peak and high cut (shown as bands 4 to 16), each with
+    // these parameters:
+    constexpr int numExtraBands = BandEngine::maxBands - 3;
+
+    enum BandField
+    {
+        BandBypassed,
+        BandFilterType,
+        BandFreq,
+        BandGain,
+        BandQuality,
+        BandSlope,
+
+        NumBandFields
+    };
+
+    constexpr int NumParameters = NumFixedParameters + numExtraBands * NumBandFields;
+
+    constexpr Index getBandParameter(int extraBand, BandField field)
+    {
+        return static_cast<Index>(NumFixedParameters + extraBand * NumBandFields + field);
+    }
+
+    enum class Type
+    {
+        Float,
+        Bool,
+        Choice,     // a cut slope: see getSlopeChoices()
+        FilterType  // a BandType: see getFilterTypeChoices()
+    };
+
+    struct Spec
+    {
+        Index index;
+        const char* id;     // (also used as the parameter name)
+        Type type;
+
+        // NormalisableRange for Float; the index range of the choices for Choice; unused for Bool:
+        float minimum, maximum, interval, skew;
+
+        float defaultValue;
+    };
+
+    inline constexpr std::array<Spec, NumFixedParameters> specs
+    {{
+        { LowCutFreq,      "LowCut Freq",      Type::Float,  20.f,  20000.f, 1.f,   0.35f, 20.f    },
+        { HighCutFreq,     "HighCut Freq",     Type::Float,  20.f,  20000.f, 1.f,   1.f,   20000.f },
+        { PeakFreq,        "Peak Freq",        Type::Float,  20.f,  20000.f, 1.f,   0.35f, 750.f   },
+        { PeakGain,        "Peak Gain",        Type::Float,  -24.f, 24.f,    1.f,   1.f,   0.f     },
+        { PeakQuality,     "Peak Quality",     Type::Float,  0.1f,  10.f,    0.05f, 1.f,   1.f     },
+        { LowCutBypassed,  "LowCut Bypassed",  Type::Bool,   0.f,   1.f,     1.f,   1.f,   0.f     },
+        { HighCutBypassed, "HighCut Bypassed", Type::Bool,   0.f,   1.f,     1.f,   1.f,   0.f     },
+        { PeakBypassed,    "Peak Bypassed",    Type::Bool,   0.f,   1.f,     1.f,   1.f,   0.f     },
+        { AnalyserEnabled, "Analyser Enabled", Type::Bool,   0.f,   1.f,     1.f,   1.f,   1.f     },
+        { LowCutSlope,     "LowCut Slope",     Type::Choice, 0.f,   3.f,     1.f,   1.f,   0.f     },
+        { HighCutSlope,    "HighCut Slope",    Type::Choice, 0.f,   3.f,     1.f,   1.f,   0.f     },
+        { SvfTopology,     "SVF Topology",     Type::Bool,   0.f,   1.f,     1.f,   1.f,   0.f     },
+    }};
+
+    constexpr bool specsAreInIndexOrder()
+    {
+        for (size_t i = 0; i < specs.size(); ++i)
+            if (specs[i].index != static_cast<Index>(i))
+                return false;
+
+        return true;
+    }
+
+    static_assert(specsAreInIndexOrder(), "Parameters::specs must list the parameters in Parameters::Index order");
+
+    // The same for every extra band, in BandField order, with the first band's index; the IDs are the band's
+    // name (e.g. "Band 4") followed by these. Extra bands start out bypassed, so they cost nothing:
+    inline constexpr std::array<Spec, NumBandFields> bandFieldSpecs
+    {{
+        { getBandParameter(0, BandBypassed),   "Bypassed", Type::Bool,       0.f,   1.f,     1.f,   1.f,   1.f     },
+        { getBandParameter(0, BandFilterType), "Type",     Type::FilterType, 0.f,   4.f,     1.f,   1.f,   0.f     },
+        { getBandParameter(0, BandFreq),       "Freq",     Type::Float,      20.f,  20000.f, 1.f,   0.35f, 1000.f  },
+        { getBandParameter(0, BandGain),       "Gain",     Type::Float,      -24.f, 24.f,    1.f,   1.f,   0.f     },
+        { getBandParameter(0, BandQuality),    "Quality",  Type::Float,      0.1f,  10.f,    0.05f, 1.f,   1.f     },
+        { getBandParameter(0, BandSlope),      "Slope",    Type::Choice,     0.f,   3.f,     1.f,   1.f,   0.f     },
+    }};
+
+    // "Band 4" to "Band 16":
+    inline juce::String getBandName(int extraBand) { return "Band " + juce::String(extraBand + 4); }
+
+    // Every parameter's spec, the extra bands' included. Their IDs are made once, and live as long as the program:
+    inline Spec getSpec(int index)
+    {
+        jassert(juce::isPositiveAndBelow(index, NumParameters));
+
+        if (index < NumFixedParameters)
+            return specs[(size_t) index];
+
+        static const auto bandIDs = []
+        {
+            juce::StringArray ids;
+            for (int band = 0; band < numExtraBands; ++band)
+                for (const auto& fieldSpec : bandFieldSpecs)
+                    ids.add(getBandName(band) + " " + fieldSpec.id);
+
+            return ids;
+        }();
+
+        const auto bandIndex = index - NumFixedParameters;
+
+        auto spec = bandFieldSpecs[(size_t) (bandIndex % NumBandFields)];
+        spec.index = static_cast<Index>(index);
+        spec.id = bandIDs[bandIndex].toRawUTF8();
+
+        return spec;
+    }
+
+    inline juce::String getID(Index index) { return getSpec(index).id; }
+
+    // "12 db/Oct", "24 db/Oct", "36 db/Oct", "48 db/Oct":
+    inline juce::StringArray getSlopeChoices()
+    {
+        juce::StringArray stringArray;
+        for (int i = 0; i < 4; ++i)
+        {
+            juce::String str;
+            str << (12 + i * 12);
+            str << " db/Oct";
+            stringArray.add(str);
+        }
+
+        return stringArray;
+    }
+
+    // In BandType order:
+    inline juce::StringArray getFilterTypeChoices()
+    {
+        return { "Bell", "Low Shelf", "High Shelf", "Low Cut", "High Cut" };
+    }
+
+    inline juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout()
+    {
+        juce::AudioProcessorValueTreeState::ParameterLayout layout;
+
+        for (int index = 0; index < NumParameters; ++index)
+        {
+            const auto spec = getSpec(index);
+
+            switch (spec.type)
+            {
+                case Type::Float:
+                    layout.add(std::make_unique<juce::AudioParameterFloat>(spec.id,
+                                                                           spec.id,
+                                                                           juce::NormalisableRange<float>(spec.minimum, spec.maximum, spec.interval, spec.skew),
+                                                                           spec.defaultValue));
+                    break;
+
+                case Type::Bool:
+                    layout.add(std::make_unique<juce::AudioParameterBool>(spec.id,
+                                                                          spec.id,
+                                                                          spec.defaultValue > 0.5f));
+                    break;
+
+                case Type::Choice:
+                case Type::FilterType:
+                    layout.add(std::make_unique<juce::AudioParameterChoice>(spec.id,
+                                                                            spec.id,
+                                                                            spec.type == Type::Choice ? getSlopeChoices() : getFilterTypeChoices(),
+                                                                            static_cast<int>(spec.defaultValue)));
+                    break;
+            }
+        }
+
+        return layout;
+    }
+
+    /**
+     Pointers to every parameter and to its raw (non-normalised) value, looked up by ID once, when constructed.
+     Reading a value is then a single atomic load, with no string hashing or tree searching, so it's fine on
+     the audio thread.
+     */
+    class Handles
+    {
+    public:
+        explicit Handles(juce::AudioProcessorValueTreeState& apvts)
+        {
+            for (int index = 0; index < NumParameters; ++index)
+            {
+                const auto spec = getSpec(index);
+
+                parameters[spec.index] = apvts.getParameter(spec.id);
+                values[spec.index] = apvts.getRawParameterValue(spec.id);
+
+                jassert(parameters[spec.index] != nullptr && values[spec.index] != nullptr);
+            }
+        }
+
+        // Each value is independent of the others, so there's nothing to order the loads against:
+        float get(Index index) const { return values[index]->load(std::memory_order_relaxed); }
+
+        // Bool params are stored as floats:
+        bool getBool(Index index) const { return get(index) > 0.5f; }
+
+        template<typename EnumType>
+        EnumType getChoice(Index index) const { return static_cast<EnumType>(static_cast<int>(get(index))); }
+
+        juce::RangedAudioParameter& getParameter(Index index) const { return *parameters[index]; }
+
+    private:
+        std::array<juce::RangedAudioParameter*, NumParameters> parameters {};
+        std::array<std::atomic<float>*, NumParameters> values {};
+
+        JUCE_DECLARE_NON_COPYABLE (Handles)
+    };
+}
@@ -17,34 +17,13 @@ void LookAndFeel::drawRotarySlider(juce::Graphics & g, int x, int y, int width,
     
     auto enabled = slider.isEnabled();
 
-    // Create circles:
-    
-    // Fill colour (if enabled):
-    g.setColour(enabled ? Colour(97u, 18u, 167u) : Colours::darkgrey);
-    g.fillEllipse(bounds);
-    
-    // Outline colour (if enabled):
-    g.setColour(enabled ? Colour(255u, 154u, 1u): Colours::grey);
-    g.drawEllipse(bounds, 1.f);
+    // Circles, from the cache (the sprite has a 1 pixel margin for the outline):
+    auto scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+    g.drawImage(getKnobBody(bounds.getWidth(), bounds.getHeight(), scale, enabled), bounds.expanded(1.f));
     
     if (auto* rswl = dynamic_cast<RotarySliderWithLabels*>(&slider))
     {
         auto centre = bounds.getCentre();
-        Path p;
-        
-        Rectangle<float> r;
-        
-        // Set Rectangle left and right 2 pixels offset from x value (on either side):
-        r.setLeft(centre.getX() - 2);
-        r.setRight(centre.getX() + 2);
-        
-        // Set Rectangle top and bottom to top of bounding box and the centre, respectively:
-        r.setTop(bounds.getY());
-        // To avoid text being occluded, offset by text height * some constant:
-        r.setBottom(centre.getY() - rswl->getTextHeight() * 1.5);
-        
-        // Add Rectangle to Path:
-        p.addRoundedRectangle(r, 2.f);
         
         jassert(rotaryStartAngle < rotaryEndAngle);
         
@@ -53,13 +32,10 @@ void LookAndFeel::drawRotarySlider(juce::Graphics & g, int x, int y, int width,
         // Map normalised pos value to rotary slider range values (in radians):
         auto sliderAngRad = jmap(sliderPosProportional, 0.f, 1.f, rotaryStartAngle, rotaryEndAngle);
         
-        
-        // Apply transform to rotate position about centre (x, y) point:
-        p.applyTransform(AffineTransform().rotated(sliderAngRad, centre.getX(), centre.getY()));
-        
-        // Draw:
-        
-        g.fillPath(p);
+        // Rotate the cached pointer about its origin, then move it to the centre of the knob:
+        g.setColour(enabled ? Colour(255u, 154u, 1u): Colours::grey);
+        g.fillPath(getKnobPointer(bounds.getHeight() * 0.5f, rswl->getTextHeight()),
+                   AffineTransform::rotation(sliderAngRad).translated(centre));
         
         // Set text font:
         
@@ -68,6 +44,7 @@ void LookAndFeel::drawRotarySlider(juce::Graphics & g, int x, int y, int width,
         auto strWidth = g.getCurrentFont().getStringWidth(text);
         
         // Set dimensions to somewhat wider/taller than text width and height:
+        Rectangle<float> r;
         r.setSize(strWidth + 4, rswl->getTextHeight() + 2);
         r.setCentre(bounds.getCentre());
         
@@ -84,6 +61,74 @@ void LookAndFeel::drawRotarySlider(juce::Graphics & g, int x, int y, int width,
     
 }
 
+const juce::Image& LookAndFeel::getKnobBody(float width, float height, float scale, bool enabled)
+{
+    using namespace juce;
+    
+    // 1 pixel margin on each side, so that the outline isn't clipped:
+    auto imageWidth = roundToInt((width + 2.f) * scale);
+    auto imageHeight = roundToInt((height + 2.f) * scale);
+    auto key = std::make_tuple(imageWidth, imageHeight, enabled);
+    
+    auto cached = knobBodies.find(key);
+    if (cached != knobBodies.end())
+        return cached->second;
+    
+    // Sizes only change on resize or display scale changes; don't keep stale ones forever:
+    if (knobBodies.size() > 32)
+        knobBodies.clear();
+    
+    Image image(Image::ARGB, jmax(1, imageWidth), jmax(1, imageHeight), true);
+    Graphics g(image);
+    g.addTransform(AffineTransform::scale(scale));
+    
+    auto bounds = Rectangle<float>(1.f, 1.f, width, height);
+    
+    // Create circles:
+    
+    // Fill colour (if enabled):
+    g.setColour(enabled ? Colour(97u, 18u, 167u) : Colours::darkgrey);
+    g.fillEllipse(bounds);
+    
+    // Outline colour (if enabled):
+    g.setColour(enabled ? Colour(255u, 154u, 1u): Colours::grey);
+    g.drawEllipse(bounds, 1.f);
+    
+    return knobBodies.emplace(key, image).first->second;
+}
+
+const juce::Path& LookAndFeel::getKnobPointer(float radius, int textHeight)
+{
+    using namespace juce;
+    
+    auto key = std::make_tuple(radius, textHeight);
+    
+    auto cached = knobPointers.find(key);
+    if (cached != knobPointers.end())
+        return cached->second;
+    
+    if (knobPointers.size() > 32)
+        knobPointers.clear();
+    
+    Path p;
+    
+    Rectangle<float> r;
+    
+    // Set Rectangle left and right 2 pixels offset from the centre (on either side):
+    r.setLeft(-2);
+    r.setRight(2);
+    
+    // Set Rectangle top and bottom to top of the knob and the centre, respectively:
+    r.setTop(-radius);
+    // To avoid text being occluded, offset by text height * some constant:
+    r.setBottom(-textHeight * 1.5f);
+    
+    // Add Rectangle to Path:
+    p.addRoundedRectangle(r, 2.f);
+    
+    return knobPointers.emplace(key, p).first->second;
+}
+
 void LookAndFeel::drawToggleButton(juce::Graphics &g, juce::ToggleButton &toggleButton, bool shouldDrawButtonAsHighlighted, bool shouldDrawButtonAsDown)
 {
     using namespace juce;
@@ -141,18 +186,31 @@ void LookAndFeel::drawToggleButton(juce::Graphics &g, juce::ToggleButton &toggle
         
         g.strokePath(analyserButton->randomPath, PathStrokeType(1.f));
     }
+    
+    else if (dynamic_cast<TopologyButton*>(&toggleButton) != nullptr)
+    {
+        // Green while the SVFs are in use, grey for the biquads:
+        auto colour = toggleButton.getToggleState() ? Colour(0u, 172u, 1u) : Colours::dimgrey;
+        g.setColour(colour);
+        
+        auto bounds = toggleButton.getLocalBounds();
+        g.drawRect(bounds);
+        
+        g.setFont(12.f);
+        g.drawFittedText("SVF", bounds, Justification::centred, 1);
+    }
 }
     
+// start angle = ca. 7:00
+static const float rotarySliderStartAngle = juce::degreesToRadians(180.f + 45.f);
+
+// 5:00: opposite side of 12:00, + 1 full rotation:
+static const float rotarySliderEndAngle = juce::degreesToRadians(180.f - 45.f) + juce::MathConstants<float>::twoPi;
+
 void RotarySliderWithLabels::paint(juce::Graphics &g)
 {
     using namespace juce;
     
-    // start angle = ca. 7:00
-    auto startAng = degreesToRadians(180.f + 45.f);
-    
-    // 5:00: opposite side of 12:00, + 1 full rotation:
-    auto endAng = degreesToRadians(180.f-45.f) + MathConstants<float>::twoPi;
-    
     auto range = getRange();
     
     auto sliderBounds = getSliderBounds();
@@ -167,43 +225,61 @@ void RotarySliderWithLabels::paint(juce::Graphics &g)
 //    g.drawRect(sliderBounds);
     
     // Map slider value to normalised range:
-    getLookAndFeel().drawRotarySlider(g,  sliderBounds.getX(), sliderBounds.getY(), sliderBounds.getWidth(), sliderBounds.getHeight(), jmap(getValue(), range.getStart(), range.getEnd(), 0.0, 1.0), startAng, endAng, *this);
+    getLookAndFeel().drawRotarySlider(g,  sliderBounds.getX(), sliderBounds.getY(), sliderBounds.getWidth(), sliderBounds.getHeight(), jmap(getValue(), range.getStart(), range.getEnd(), 0.0, 1.0), rotarySliderStartAngle, rotarySliderEndAngle, *this);
+    
+    // Param min/max val labels (labels may have been added since the last resize):
+    if (labelBounds.size() != labels.size())
+        updateLabelBounds();
     
-    // Param min/max val labels:
+    g.setColour(Colour(0u, 172u, 1u));
+    g.setFont(getTextHeight());
+    
+    for (int i = 0; i < labels.size(); ++i)
+        g.drawFittedText(labels[i].label, labelBounds[i], juce::Justification::centred, 1);
+}
+
+void RotarySliderWithLabels::resized()
+{
+    juce::Slider::resized();
+    
+    updateLabelBounds();
+}
+
+void RotarySliderWithLabels::updateLabelBounds()
+{
+    using namespace juce;
+    
+    labelBounds.clearQuick();
     
     // Bounding box:
     
+    auto sliderBounds = getSliderBounds();
     auto centre = sliderBounds.toFloat().getCentre();
     auto radius = sliderBounds.getWidth() * 0.5f;
     
-    g.setColour(Colour(0u, 172u, 1u));
-    g.setFont(getTextHeight());
+    Font font(getTextHeight());
     
     // Iterate through labels:
-    auto numChoices = labels.size();
-    for (int i = 0; i < numChoices; ++i)
+    for (const auto& labelPos : labels)
     {
-        auto pos = labels[i].pos;
+        auto pos = labelPos.pos;
         jassert(0.f <= pos);
         jassert(pos <= 1.f);
         
-        auto ang = jmap(pos, 0.f, 1.f, startAng, endAng);
+        auto ang = jmap(pos, 0.f, 1.f, rotarySliderStartAngle, rotarySliderEndAngle);
         
         // Place centre at edge of slider bounding box, not colliding with circle:
-        auto c = centre.getPointOnCircumference(radius + getTextHeight() * 0.5 + 1, ang);
+        auto c = centre.getPointOnCircumference(radius + getTextHeight() * 0.5f + 1, ang);
         
         Rectangle<float> r;
         
-        auto str = labels[i].label;
-        
-        r.setSize(g.getCurrentFont().getStringWidth(str), getTextHeight());
+        r.setSize(font.getStringWidth(labelPos.label), getTextHeight());
         r.setCentre(c);
         
         // Shift down (along y axis) from circle:
         r.setY(r.getY() + getTextHeight());
         
-        g.drawFittedText(str, r.toNearestInt(), juce::Justification::centred, 1);
-        
+        labelBounds.add(r.toNearestInt());
     }
 }
 
@@ -231,14 +307,14 @@ juce::String RotarySliderWithLabels::getDisplayString() const
 {
 //    return juce::String(getValue());
     
-    if (auto * choiceParam = dynamic_cast<juce::AudioParameterChoice*>(param))
+    if (choiceParam != nullptr)
         return choiceParam->getCurrentChoiceName();
     
     juce::String str;
     // Whether or not to express freq value as Khz:
     bool addK = false;
     
-    if (auto * floatParam = dynamic_cast<juce::AudioParameterFloat*>(param))
+    if (floatParam != nullptr)
     {
         float val = getValue();
         
@@ -273,8 +349,7 @@ juce::String RotarySliderWithLabels::getDisplayString() const
 // =========================================================================================
 ResponseCurveComponent::ResponseCurveComponent(SimpleEQAudioProcessor& p):
 audioProcessor(p),
-leftPathProducer(audioProcessor.leftChannelFifo),
-rightPathProducer(audioProcessor.rightChannelFifo)
+vBlankAttachment(this, [this] { onVBlank(); })
 {
     const auto& params = audioProcessor.getParameters();
 
@@ -285,12 +360,11 @@ rightPathProducer(audioProcessor.rightChannelFifo)
         param->addListener(this);
     }
     
+    // Start with the analyser as the session left it, so a disabled one never gets created:
+    shouldShowFFTAnalysis = audioProcessor.parameterHandles.getBool(Parameters::AnalyserEnabled);
    
     // Update MonoChain (at launch/reopening of plugin GUI):
     updateChain();
-    
-    // Start timer:
-    startTimerHz(60);
 }
 
 ResponseCurveComponent::~ResponseCurveComponent() {
@@ -308,83 +382,320 @@ void ResponseCurveComponent::parameterValueChanged(int parameterIndex, float new
     parametersChanged.set(true);
 }
 
-void PathProducer::process(juce::Rectangle<float> fftBounds, double sampleRate)
+bool PathProducer::process(juce::Rectangle<float> fftBounds, double sampleRate)
 {
-    juce::AudioBuffer<float> tempIncomingBuffer;
-    
+    // No sample rate before prepareToPlay(): nothing to analyse yet.
+    if (sampleRate <= 0.0)
+        return false;
+
+    // (Re)build the decimation cascade when the sample rate changes:
+    if (sampleRate != preparedSampleRate)
+    {
+        leftChannelFFTDataGenerator.prepare(FFTOrder::order2048, sampleRate, -48.f);
+        preparedSampleRate = sampleRate;
+    }
+
     while (leftChannelFifo->getNumCompleteBuffersAvailable() > 0)
     {
-        if (leftChannelFifo->getAudioBuffer(tempIncomingBuffer))
+        if (leftChannelFifo->getAudioBuffer(incomingBuffer, frameStamp))
         {
-            auto size  = tempIncomingBuffer.getNumSamples();
-            
-            // shift all content of increment num_samples - size to the 0 index:
-            juce::FloatVectorOperations::copy(monoBuffer.getWritePointer(0, 0),
-                                              monoBuffer.getReadPointer(0, size),
-                                              monoBuffer.getNumSamples() - size);
+            dequeuedTicks = juce::Time::getHighResolutionTicks();
             
-            // copy most recent block from tempIncomingBuffer to end of monoBuffer;
-            // position in buffer depends upon size of tempIncomingBuffer:
-            juce::FloatVectorOperations::copy(monoBuffer.getWritePointer(0, monoBuffer.getNumSamples() - size),
-                                              tempIncomingBuffer.getReadPointer(0, 0),
-                                              size);
-            
-            leftChannelFFTDataGenerator.produceFFTDataForRendering(monoBuffer, -48.f);
+            // The generator keeps its own rolling buffer per decimation level:
+            leftChannelFFTDataGenerator.produceFFTDataForRendering(incomingBuffer, -48.f);
         }
-        
+
     }
-    
+
     /*
-     If there are FFT data buffers to pull,
-     and if a buffer can be pulled,
-     generate a path via pathProducer.
+     Pull all available FFT data buffers, but only generate a path
+     for the most recent one: that is the only one that gets displayed.
      */
-    const auto fftSize = leftChannelFFTDataGenerator.getFFTSize();
+    bool hasNewData = false;
+
+    while (leftChannelFFTDataGenerator.getNumAvailableFFTDataBlocks() > 0)
+    {
+        hasNewData |= leftChannelFFTDataGenerator.getFFTData(fftData);
+    }
+
+    if (hasNewData)
+    {
+        pathProducer.generatePath(fftData,
+                                  leftChannelFFTDataGenerator.getBinFrequencies(),
+                                  fftBounds,
+                                  -48.f,
+                                  leftChannelFFTPath);
+    }
+
+    return hasNewData;
+}
+
+std::shared_ptr<juce::dsp::FFT> SharedAnalyzerResources::getFFT(int order)
+{
+    const juce::ScopedLock sl(lock);
     
-    // bin width = 48000 / 2048 = 23 Hz
-    const auto binWidth = sampleRate / (double)fftSize;
+    auto fft = ffts[order].lock();
+    if (fft == nullptr)
+    {
+        fft = std::make_shared<juce::dsp::FFT>(order);
+        ffts[order] = fft;
+    }
     
-    while (leftChannelFFTDataGenerator.getNumAvailableFFTDataBlocks() > 0)
+    return fft;
+}
+
+std::shared_ptr<juce::dsp::WindowingFunction<float>> SharedAnalyzerResources::getBlackmanHarrisWindow(int size)
+{
+    const juce::ScopedLock sl(lock);
+    
+    auto window = windows[size].lock();
+    if (window == nullptr)
+    {
+        window = std::make_shared<juce::dsp::WindowingFunction<float>>(size, juce::dsp::WindowingFunction<float>::blackmanHarris);
+        windows[size] = window;
+    }
+    
+    return window;
+}
+
+std::shared_ptr<const BinToPixelMap> SharedAnalyzerResources::getBinToPixelMap(const std::vector<float>& binFrequencies, int width)
+{
+    const juce::ScopedLock sl(lock);
+    
+    // Drop the maps nobody uses anymore (e.g. after a resize):
+    for (auto it = binToPixelMaps.begin(); it != binToPixelMaps.end();)
+        it = it->second.expired() ? binToPixelMaps.erase(it) : std::next(it);
+    
+    auto key = std::make_tuple(width, (int) binFrequencies.size(), binFrequencies.empty() ? 0.f : binFrequencies.back());
+    
+    auto map = binToPixelMaps[key].lock();
+    if (map == nullptr)
+    {
+        map = std::make_shared<const BinToPixelMap>(binFrequencies, width);
+        binToPixelMaps[key] = map;
+    }
+    
+    return map;
+}
+
+AnalyzerRenderThread::AnalyzerRenderThread(SimpleEQAudioProcessor& p):
+juce::Thread("SimpleEQ Analyzer"),
+leftPathProducer(p.leftChannelFifo),
+rightPathProducer(p.rightChannelFifo),
+analyzerLoad(p.analyzerLoad),
+latency(p.analyzerLatency)
+{
+}
+
+AnalyzerRenderThread::~AnalyzerRenderThread()
+{
+    signalThreadShouldExit();
+    notify();
+    stopThread(1000);
+}
+
+void AnalyzerRenderThread::setAnalysisSize(int width, int height, float scale)
+{
+    analysisWidth.set(width);
+    analysisHeight.set(height);
+    analysisScale.set(scale);
+}
+
+void AnalyzerRenderThread::run()
+{
+    while (! threadShouldExit())
     {
-        std::vector<float> fftData;
-        if (leftChannelFFTDataGenerator.getFFTData(fftData))
+        // Sleep until the next display refresh:
+        wait(-1);
+        
+        if (threadShouldExit())
+            break;
+        
+        auto width = analysisWidth.get();
+        auto height = analysisHeight.get();
+        
+        if (! analysisEnabled.get() || width <= 0 || height <= 0)
+            continue;
+        
+        // Timed against a display frame, which is how often this runs:
+        const LoadMeter::ScopedMeasurement measurement(analyzerLoad, LoadMeter::displayFrameSeconds);
+        
+        // The paths are generated straight into image coordinates; drawFrame() positions the image:
+        auto fftBounds = juce::Rectangle<float>(0.f, 0.f, (float) width, (float) height);
+        auto sampleRate = currentSampleRate.get();
+        
+        // (both producers must run, to keep draining their FIFOs)
+        auto leftProduced = leftPathProducer.process(fftBounds, sampleRate);
+        auto rightProduced = rightPathProducer.process(fftBounds, sampleRate);
+        
+        if (leftProduced || rightProduced)
         {
-            pathProducer.generatePath(fftData, fftBounds, fftSize, binWidth, -48.f);
+            // (the left channel's stamp stands for the frame: both channels are captured in the same blocks)
+            const auto& stamp = leftPathProducer.getFrameStamp();
+            latency.record(AnalyzerLatency::Dequeued, stamp, leftPathProducer.getDequeuedTicks());
+            latency.record(AnalyzerLatency::Analysed, stamp);
+            
+            renderFrame(width, height, analysisScale.get(), stamp);
+            latency.record(AnalyzerLatency::Rendered, stamp);
+            
+            newFrameAvailable.set(true);
         }
     }
+}
+
+void AnalyzerRenderThread::renderFrame(int width, int height, float scale, const FrameStamp& stamp)
+{
+    using namespace juce;
     
-    /* While there are paths that can be pulled,
-       pull as many as possible;
-       display most recent path.
-     */
+    auto& backImage = images[1 - frontImageIndex];
+    
+    if (backImage.getWidth() != width || backImage.getHeight() != height)
+    {
+        // SoftwareImageType: safe to create and draw into off the message thread.
+        backImage = Image(Image::ARGB, width, height, true, SoftwareImageType());
+    }
+    else
+    {
+        backImage.clear(backImage.getBounds());
+    }
     
-    while (pathProducer.getNumPathsAvailable())
     {
-        pathProducer.getPath(leftChannelFFTPath);
+        Image::BitmapData bitmap(backImage, Image::BitmapData::readWrite);
+        
+        // The paths are borrowed, and already in image coordinates. The traces stay 1 logical pixel wide:
+        const auto thickness = jmax(1, roundToInt(scale));
+        rasterizePolyline(bitmap, leftPathProducer.getPath(), Colours::skyblue.getPixelARGB(), thickness);
+        rasterizePolyline(bitmap, rightPathProducer.getPath(), Colours::darkcyan.getPixelARGB(), thickness);
     }
+    
+    const ScopedLock sl(imageLock);
+    imageStamps[(size_t) (1 - frontImageIndex)] = stamp;
+    frontImageIndex = 1 - frontImageIndex;
 }
 
-void ResponseCurveComponent::timerCallback()
+bool AnalyzerRenderThread::pullNewFrame()
 {
-    if (shouldShowFFTAnalysis)
+    if (! newFrameAvailable.compareAndSetBool(false, true))
+        return false;
+    
+    FrameStamp stamp;
+    {
+        const juce::ScopedLock sl(imageLock);
+        stamp = imageStamps[(size_t) frontImageIndex];
+    }
+    
+    latency.record(AnalyzerLatency::PickedUp, stamp);
+    return true;
+}
+
+void AnalyzerRenderThread::drawFrame(juce::Graphics& g, juce::Rectangle<int> area)
+{
+    const juce::ScopedLock sl(imageLock);
+    
+    auto& frontImage = images[frontImageIndex];
+    
+    // (at physical resolution, so scaling it back to the logical area maps it 1:1 onto the display)
+    if (frontImage.isValid())
+        g.drawImage(frontImage, area.toFloat());
+    
+    // Only the first paint of each frame counts (the same frame gets repainted until the next one arrives):
+    const auto& stamp = imageStamps[(size_t) frontImageIndex];
+    
+    if (stamp.samplePosition != lastPaintedSamplePosition)
+    {
+        latency.record(AnalyzerLatency::Painted, stamp);
+        lastPaintedSamplePosition = stamp.samplePosition;
+    }
+}
+
+void AnalyzerRenderThread::rasterizePolyline(juce::Image::BitmapData& bitmap,
+                                             const juce::Path& path,
+                                             juce::PixelARGB pixel,
+                                             int thickness)
+{
+    auto fillColumn = [&bitmap, pixel, thickness](int x, float yA, float yB)
+    {
+        auto yStart = juce::jlimit(0, bitmap.height - 1, (int) std::floor(juce::jmin(yA, yB)));
+        auto yEnd = juce::jlimit(0, bitmap.height - 1, (int) std::floor(juce::jmax(yA, yB)) + thickness - 1);
+        
+        for (int column = juce::jmax(0, x); column < juce::jmin(bitmap.width, x + thickness); ++column)
+            for (int y = yStart; y <= yEnd; ++y)
+                *reinterpret_cast<juce::PixelARGB*>(bitmap.getPixelPointer(column, y)) = pixel;
+    };
+    
+    juce::Path::Iterator it(path);
+    juce::Point<float> previous;
+    bool hasPrevious = false;
+    
+    while (it.next())
     {
+        auto point = juce::Point<float>(it.x1, it.y1);
+        
+        if (it.elementType == juce::Path::Iterator::lineTo && hasPrevious)
+        {
+            auto start = previous, end = point;
+            if (end.x < start.x)
+                std::swap(start, end);
+            
+            auto xStart = (int) std::floor(start.x);
+            auto xEnd = (int) std::floor(end.x);
+            auto slope = end.x > start.x ? (end.y - start.y) / (end.x - start.x) : 0.f;
+            
+            // Fill the vertical span the segment covers within each column:
+            for (int x = xStart; x <= xEnd; ++x)
+            {
+                auto xA = juce::jmax(start.x, (float) x);
+                auto xB = juce::jmin(end.x, (float) (x + 1));
+                
+                fillColumn(x, start.y + slope * (xA - start.x), start.y + slope * (xB - start.x));
+            }
+        }
+        
+        // (the paths only contain startNewSubPath/lineTo elements)
+        previous = point;
+        hasPrevious = true;
+    }
+}
+
+void ResponseCurveComponent::onVBlank()
+{
+    // Nothing to do while the editor is hidden or minimised (isShowing() checks both):
+    if (! isShowing())
+        return;
     
-        auto fftBounds = getAnalysisArea().toFloat();
-        auto sampleRate = audioProcessor.getSampleRate();
+    // Only repaint when there is something new to draw:
+    bool needsRepaint = false;
     
-        leftPathProducer.process(fftBounds, sampleRate);
-        rightPathProducer.process(fftBounds, sampleRate);
+    if (shouldShowFFTAnalysis)
+    {
+        // Bring the analyser up on first use:
+        if (analyzerRenderThread == nullptr)
+        {
+            analyzerRenderThread = std::make_unique<AnalyzerRenderThread>(audioProcessor);
+            updateAnalysisSize();
+            analyzerRenderThread->startThread();
+        }
+        
+        // Wake the render thread for the next frame, and pick up the one it finished since the last refresh:
+        analyzerRenderThread->setSampleRate(audioProcessor.getSampleRate());
+        analyzerRenderThread->notify();
+        
+        needsRepaint |= analyzerRenderThread->pullNewFrame();
     }
     
-    if(parametersChanged.compareAndSetBool(false, true))
+    // (a preset slot being selected, stored or morphed changes the curve as much as a parameter does)
+    if(parametersChanged.compareAndSetBool(false, true)
+       || audioProcessor.presetSlots.getChangeCount() != presetSlotsChangeCount)
     {
         updateChain();
         
         // Signal a repaint (draw new response curve)
-//        repaint();
+        needsRepaint = true;
     }
-    // Pepaint all the time, as paths are being produced continuously:
-    repaint();
+    
+    // The labels outside the render area are part of the cached background, and never change here:
+    if (needsRepaint)
+        repaint(getRenderArea());
 }
 
 // To ensure that current parameters are displayed in response curve at plugin launch:
@@ -394,116 +705,281 @@ void ResponseCurveComponent::updateChain()
     
     double sampleRate = audioProcessor.getSampleRate();
     
-    auto chainSettings = getChainSettings(audioProcessor.apvts);
+    // Only redesign (and re-evaluate) the bands whose settings actually changed:
+    const bool updateAll = ! hasCachedChainSettings || sampleRate != cachedSampleRate;
+    cachedSampleRate = sampleRate;
+    
+    // The frequency grid's cos/sin terms depend on the sample rate:
+    if (updateAll)
+        updatePixelFrequencies();
+    
+    const bool extraBandsChanged = updateExtraBands();
+    
+    // (read before the slots, so a change made meanwhile brings another update)
+    presetSlotsChangeCount = audioProcessor.presetSlots.getChangeCount();
+    
+    auto chainSettings = getChainSettings(audioProcessor.parameterHandles);
+    
+    // A selected preset slot overrides the parameters, as it does in the processor:
+    PresetSlots::ActiveSettings slotSettings;
+    
+    if (audioProcessor.presetSlots.getActiveSettings(slotSettings))
+    {
+        // The biquads blend the two slots' designs, which isn't the design of any one set of settings:
+        if (slotSettings.isMorphing && ! audioProcessor.parameterHandles.getBool(Parameters::SvfTopology))
+        {
+            updateBlendedMagnitudes(slotSettings);
+            return;
+        }
+        
+        // (whereas the SVFs glide to the blended settings themselves)
+        chainSettings = slotSettings.isMorphing ? interpolateChainSettings(slotSettings.slot, slotSettings.target, slotSettings.amount)
+                                                : slotSettings.slot;
+    }
+    
+    const auto& cached = cachedChainSettings;
+    
+    const bool lowCutChanged = updateAll
+                            || chainSettings.lowCutFreq != cached.lowCutFreq
+                            || chainSettings.lowCutSlope != cached.lowCutSlope
+                            || chainSettings.lowCutBypassed != cached.lowCutBypassed;
+    
+    const bool peakChanged = updateAll
+                          || chainSettings.peakFreq != cached.peakFreq
+                          || chainSettings.peakGainInDecibels != cached.peakGainInDecibels
+                          || chainSettings.peakQuality != cached.peakQuality
+                          || chainSettings.peakBypassed != cached.peakBypassed;
+    
+    const bool highCutChanged = updateAll
+                             || chainSettings.highCutFreq != cached.highCutFreq
+                             || chainSettings.highCutSlope != cached.highCutSlope
+                             || chainSettings.highCutBypassed != cached.highCutBypassed;
+    
+    cachedChainSettings = chainSettings;
+    hasCachedChainSettings = true;
     
     // Update curve with filter bypass settings
-    monoChain.setBypassed<ChainPositions::LowCut>(chainSettings.lowCutBypassed);
-    monoChain.setBypassed<ChainPositions::HighCut>(chainSettings.highCutBypassed);
-    monoChain.setBypassed<ChainPositions::Peak>(chainSettings.peakBypassed);
+    if (lowCutChanged)
+    {
+        monoChain.setBypassed<ChainPositions::LowCut>(chainSettings.lowCutBypassed);
+        updateLowCutMagnitudes();
+    }
+    
+    if (peakChanged)
+    {
+        monoChain.setBypassed<ChainPositions::Peak>(chainSettings.peakBypassed);
+        
+        auto peakCoefficients = makePeakFilter(chainSettings, sampleRate);
+        updateCoefficients(monoChain.get<ChainPositions::Peak>().coefficients, peakCoefficients);
+        
+        updatePeakMagnitudes();
+    }
+    
+    if (highCutChanged)
+    {
+        monoChain.setBypassed<ChainPositions::HighCut>(chainSettings.highCutBypassed);
+        updateHighCutMagnitudes();
+    }
     
+    if (lowCutChanged || peakChanged || highCutChanged || extraBandsChanged)
+        updateResponseCurve();
+}
+
+bool ResponseCurveComponent::updateExtraBands()
+{
+    bool changed = false;
     
-    auto peakCoefficients = makePeakFilter(chainSettings, sampleRate);
-    updateCoefficients(monoChain.get<ChainPositions::Peak>().coefficients, peakCoefficients);
+    // (designed at the processor's rate, as that's what they sound like; before prepareToPlay() they stay flat)
+    if (cachedSampleRate != extraBandsSampleRate)
+    {
+        extraBands.prepare(cachedSampleRate, 0);
+        extraBandsSampleRate = cachedSampleRate;
+        changed = true;
+    }
     
-    auto lowCutCoefficients = makeLowCutFilter(chainSettings, sampleRate);
-    auto highCutCoefficients = makeHighCutFilter(chainSettings, sampleRate);
+    for (int i = 0; i < Parameters::numExtraBands; ++i)
+    {
+        const auto index = ChainPositions::HighCut + 1 + i;
+        const auto settings = getBandSettings(audioProcessor.parameterHandles, i);
+        
+        if (settings != extraBands.getBand(index))
+        {
+            extraBands.setBand(index, settings);
+            changed = true;
+        }
+    }
     
-    updateCutFilter(monoChain.get<LowCut>(), lowCutCoefficients, chainSettings.lowCutSlope);
-    updateCutFilter(monoChain.get<HighCut>(), highCutCoefficients, chainSettings.highCutSlope);
+    if (changed || extraBandMagnitudes.size() != (size_t) magnitudeEvaluator.getNumPoints())
+        updateExtraBandMagnitudes();
     
+    return changed;
 }
+
+void ResponseCurveComponent::updateExtraBandMagnitudes()
+{
+    extraBandMagnitudes.assign((size_t) magnitudeEvaluator.getNumPoints(), 1.0);
     
-void ResponseCurveComponent::paint (juce::Graphics& g)
+    // (disabled bands, usually most of them, cost nothing here either)
+    if (! extraBandMagnitudes.empty())
+        extraBands.multiplyMagnitudes(magnitudeEvaluator, extraBandMagnitudes.data());
+}
+
+void ResponseCurveComponent::updatePixelFrequencies()
 {
-    using namespace juce;
-    // (Our component is opaque, so we must completely fill the background with a solid colour)
-    //    g.fillAll (getLookAndFeel().findColour (juce::ResizableWindow::backgroundColourId));
-       
-    // Black background:
-    g.fillAll(Colours::black);
+    // The grid only changes with the width of the analysis area or the sample rate
+    // (which is unknown before prepareToPlay()):
+    auto w = cachedSampleRate > 0.0 ? juce::jmax(0, getAnalysisArea().getWidth()) : 0;
     
-    // Draw background grid: 
-    g.drawImage(background, getLocalBounds().toFloat());
-        
-//    auto responseArea = getLocalBounds();
+    if (! magnitudeEvaluator.isPreparedFor(w, cachedSampleRate))
+        magnitudeEvaluator.prepare(w, cachedSampleRate);
+}
 
-    // Reduced bounds:
-    auto responseArea = getAnalysisArea();
-        
-    auto w = responseArea.getWidth();
+// Product of the magnitudes of a cut's sections, designed in float exactly as the processor designs them:
+static void multiplyCutSectionMagnitudes(BiquadMagnitudeEvaluator& evaluator, bool isHighPass, float cutoff, int order, double* mags)
+{
+    std::array<SectionDesign::Section, ChainCoefficients::numCutSections> sections;
+    SectionDesign::designButterworth(isHighPass, cutoff, order, evaluator.getSampleRate(), sections.data());
+    
+    for (int i = 0; i < order / 2; ++i)
+    {
+        const auto& s = sections[(size_t) i];
+        evaluator.multiplyMagnitudes(s[0], s[1], s[2], s[3], s[4], mags);
+    }
+}
+
+// In debug builds, check the closed form against the product of the designed sections:
+static void validateCutMagnitudes(BiquadMagnitudeEvaluator& evaluator, bool isHighPass, float cutoff, int order,
+                                  const std::vector<double>& closedFormMags)
+{
+   #if JUCE_DEBUG
+    std::vector<double> sectionMags(closedFormMags.size(), 1.0);
+    multiplyCutSectionMagnitudes(evaluator, isHighPass, cutoff, order, sectionMags.data());
+    
+    for (size_t i = 0; i < closedFormMags.size(); ++i)
+    {
+        auto closedFormDb = juce::Decibels::gainToDecibels(closedFormMags[i]);
+        auto sectionDb = juce::Decibels::gainToDecibels(sectionMags[i]);
         
-    auto& lowcut = monoChain.get<ChainPositions::LowCut>();
-    auto& highcut = monoChain.get<ChainPositions::HighCut>();
+        // Float coefficients limit the agreement deep in the stop band:
+        if (sectionDb > -60.0)
+            jassert(std::abs(closedFormDb - sectionDb) < 0.1);
+    }
+   #else
+    juce::ignoreUnused(evaluator, isHighPass, cutoff, order, closedFormMags);
+   #endif
+}
+
+void ResponseCurveComponent::updateCutMagnitudes(bool isHighPass, float cutoff, Slope slope, std::vector<double>& magnitudes)
+{
+    if (magnitudes.empty())
+        return;
+    
+    const auto order = (slope + 1) * 2;
+    
+    // The cut bands are Butterworth cascades, so where the filters really behave like one, their combined
+    // magnitude is evaluated in closed form; otherwise the curve shows what the designed sections do:
+    if (cutoff / magnitudeEvaluator.getSampleRate() < BiquadMagnitudeEvaluator::minButterworthCutoffRatio)
+    {
+        multiplyCutSectionMagnitudes(magnitudeEvaluator, isHighPass, cutoff, order, magnitudes.data());
+        return;
+    }
+    
+    magnitudeEvaluator.multiplyButterworthMagnitudes(isHighPass, cutoff, order, magnitudes.data());
+    validateCutMagnitudes(magnitudeEvaluator, isHighPass, cutoff, order, magnitudes);
+}
+
+void ResponseCurveComponent::updateLowCutMagnitudes()
+{
+    lowCutMagnitudes.assign((size_t) magnitudeEvaluator.getNumPoints(), 1.0);
+    
+    if (monoChain.isBypassed<ChainPositions::LowCut>())
+        return;
+    
+    updateCutMagnitudes(true, cachedChainSettings.lowCutFreq, cachedChainSettings.lowCutSlope, lowCutMagnitudes);
+}
+
+void ResponseCurveComponent::updatePeakMagnitudes()
+{
+    peakMagnitudes.assign((size_t) magnitudeEvaluator.getNumPoints(), 1.0);
+    
+    // If filter is not bypassed, the magnitude = the magnitude of the given frequency:
+    if (monoChain.isBypassed<ChainPositions::Peak>())
+        return;
+    
     auto& peak = monoChain.get<ChainPositions::Peak>();
+    magnitudeEvaluator.multiplyMagnitudes(*peak.coefficients, peakMagnitudes.data());
+}
+
+void ResponseCurveComponent::updateHighCutMagnitudes()
+{
+    highCutMagnitudes.assign((size_t) magnitudeEvaluator.getNumPoints(), 1.0);
+    
+    if (monoChain.isBypassed<ChainPositions::HighCut>())
+        return;
+    
+    updateCutMagnitudes(false, cachedChainSettings.highCutFreq, cachedChainSettings.highCutSlope, highCutMagnitudes);
+}
+
+void ResponseCurveComponent::updateBlendedMagnitudes(const PresetSlots::ActiveSettings& slotSettings)
+{
+    // The per-band magnitudes no longer belong to any cached settings, so the next update redoes every band:
+    hasCachedChainSettings = false;
+    
+    const auto numPoints = (size_t) magnitudeEvaluator.getNumPoints();
+    
+    lowCutMagnitudes.assign(numPoints, 1.0);
+    peakMagnitudes.assign(numPoints, 1.0);
+    highCutMagnitudes.assign(numPoints, 1.0);
+    
+    if (numPoints > 0)
+    {
+        const auto sampleRate = magnitudeEvaluator.getSampleRate();
         
-    auto sampleRate = audioProcessor.getSampleRate();
+        ChainCoefficients blended;
+        interpolateChainCoefficients(makeChainCoefficients(slotSettings.slot, sampleRate),
+                                     makeChainCoefficients(slotSettings.target, sampleRate),
+                                     slotSettings.amount,
+                                     blended);
         
-    std::vector<double> mags;
+        // (bypassed and unused sections are unity)
+        auto multiply = [this](const ChainCoefficients::Section& s, std::vector<double>& magnitudes)
+        {
+            magnitudeEvaluator.multiplyMagnitudes(s[0], s[1], s[2], s[3], s[4], magnitudes.data());
+        };
         
-    mags.resize(w);
+        for (const auto& section : blended.lowCut)
+            multiply(section, lowCutMagnitudes);
         
-    // Iterate through magnitude vector, convert from pixels to Hz:
+        multiply(blended.peak, peakMagnitudes);
         
-    for (int i = 0; i < w; ++i)
-    {
-        double mag = 1.f;
-        auto freq = mapToLog10(double(i) / double(w), 20.0, 20000.0);
-            
-        // If filter is not bypassed, the magnitude = the magnitude of the given frequency:
-        if (!monoChain.isBypassed<ChainPositions::Peak>())
-        {
-            mag *= peak.coefficients->getMagnitudeForFrequency(freq, sampleRate);
-        }
-                
-        // Only check conditions/execute if lowcut filter is not bypassed:
-        if (!monoChain.isBypassed<ChainPositions::LowCut>())
-        {
-            if (!lowcut.isBypassed<0>())
-            {
-                mag *= lowcut.get<0>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-            }
-            if (!lowcut.isBypassed<1>())
-            {
-                mag *= lowcut.get<1>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-            }
-            if (!lowcut.isBypassed<2>())
-            {
-                mag *= lowcut.get<2>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-            }
-            if (!lowcut.isBypassed<3>())
-            {
-                mag *= lowcut.get<3>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-            }
-        }
-            
-        if (!monoChain.isBypassed<ChainPositions::HighCut>())
-        {
-            if (!highcut.isBypassed<0>())
-            {
-                mag *= highcut.get<0>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-            }
-            if (!highcut.isBypassed<1>())
-            {
-                mag *= highcut.get<1>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-            }
-            if (!highcut.isBypassed<2>())
-            {
-                mag *=highcut.get<2>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-            }
-            if (!highcut.isBypassed<3>())
-            {
-                mag *= highcut.get<3>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-            }
-        }
-            
-        // Convert magnitude from gain value to dB and store value to mags vector:
-            
-        mags[i] = Decibels::gainToDecibels(mag);
+        for (const auto& section : blended.highCut)
+            multiply(section, highCutMagnitudes);
     }
     
-    // Create path:
-    Path responseCurve;
-        
+    updateResponseCurve();
+}
+
+void ResponseCurveComponent::updateResponseCurve()
+{
+    updateResponseCurvePath();
+    strokeResponseCurve();
+}
+
+void ResponseCurveComponent::updateResponseCurvePath()
+{
+    using namespace juce;
+    
+    responseCurve.clear();
+    
+    // Reduced bounds:
+    auto responseArea = getAnalysisArea();
+    
+    const auto numPoints = (size_t) magnitudeEvaluator.getNumPoints();
+    
+    // (left empty: strokeResponseCurve() then drops the image)
+    if (numPoints == 0 || getWidth() <= 0 || getHeight() <= 0)
+        return;
+    
     const double outputMin = responseArea.getBottom();
     const double outputMax = responseArea.getY();
         
@@ -513,46 +989,108 @@ void ResponseCurveComponent::paint (juce::Graphics& g)
     {
         return jmap(input, -24.0, 24.0, outputMin, outputMax);
     };
+    
+    // Combine the bands and convert magnitude from gain value to dB:
+    auto magnitudeAt = [this] (size_t i)
+    {
+        return Decibels::gainToDecibels(lowCutMagnitudes[i] * peakMagnitudes[i] * highCutMagnitudes[i] * extraBandMagnitudes[i]);
+    };
+    
+    responseCurve.preallocateSpace(3 * (int) numPoints);
         
     // Start new subpath and run map function on first magnitude value:
-        
-    responseCurve.startNewSubPath(responseArea.getX(), map(mags.front()));
+    responseCurve.startNewSubPath(responseArea.getX(), map(magnitudeAt(0)));
         
     // Iterate over all magnitudes and map:
-    for (size_t i = 1; i < mags.size(); ++i)
+    for (size_t i = 1; i < numPoints; ++i)
     {
-        responseCurve.lineTo(responseArea.getX() + i , map(mags[i]));
+        responseCurve.lineTo(responseArea.getX() + i , map(magnitudeAt(i)));
     }
+}
+
+void ResponseCurveComponent::strokeResponseCurve()
+{
+    using namespace juce;
     
-    if (shouldShowFFTAnalysis)
+    if (responseCurve.isEmpty())
     {
+        responseCurveImage = {};
+        return;
+    }
+    
+    // Stroke the curve once here, rather than in every paint(), at the display's resolution:
+    const auto imageWidth = jmax(1, roundToInt((float) getWidth() * displayScale));
+    const auto imageHeight = jmax(1, roundToInt((float) getHeight() * displayScale));
+    
+    if (responseCurveImage.getWidth() != imageWidth || responseCurveImage.getHeight() != imageHeight)
+        responseCurveImage = Image(Image::ARGB, imageWidth, imageHeight, true);
+    else
+        responseCurveImage.clear(responseCurveImage.getBounds());
+    
+    Graphics g(responseCurveImage);
+    g.addTransform(AffineTransform::scale(displayScale));
     
-        auto leftChannelFFTPath = leftPathProducer.getPath();
+    // Keep the curve inside the render area (onVBlank() only invalidates that area):
+    g.reduceClipRegion(getRenderArea());
     
-        // Translate FFT spectrum analyser function to response area origin:
-        leftChannelFFTPath.applyTransform(AffineTransform().translation(responseArea.getX(), responseArea.getY() - 10.f));
+    g.setColour(Colours::white);
+    g.strokePath(responseCurve, PathStrokeType(2.f));
+}
+    
+void ResponseCurveComponent::paint (juce::Graphics& g)
+{
+    using namespace juce;
     
-        // Paint FFT analysis path for left channel:
-        g.setColour(Colours::skyblue);
-        g.strokePath(leftChannelFFTPath, PathStrokeType(1.f));
+    const LoadMeter::ScopedMeasurement measurement(audioProcessor.paintLoad, LoadMeter::displayFrameSeconds);
     
-        auto rightChannelFFTPath = rightPathProducer.getPath();
-        rightChannelFFTPath.applyTransform(AffineTransform().translation(responseArea.getX(), responseArea.getY() - 10.f));
+    // First paint, or moved to a display with another scale: render the images at its resolution from now on.
+    const auto scale = g.getInternalContext().getPhysicalPixelScaleFactor();
     
-        // Paint FFT analysis path for right channel:
-        g.setColour(Colours::darkcyan);
-        g.strokePath(rightChannelFFTPath, PathStrokeType(1.f));
+    if (scale != displayScale)
+    {
+        displayScale = scale;
+        strokeResponseCurve();
+        updateAnalysisSize();
     }
     
+    // (Our component is opaque, so we must completely fill the background with a solid colour)
+    //    g.fillAll (getLookAndFeel().findColour (juce::ResizableWindow::backgroundColourId));
+       
+    // Black background:
+    g.fillAll(Colours::black);
+    
+    // Draw background grid: 
+    g.drawImage(background, getLocalBounds().toFloat());
+        
+    // Reduced bounds:
+    auto responseArea = getAnalysisArea();
+    
+    // FFT analysis traces for both channels, rasterised by the render thread:
+    if (shouldShowFFTAnalysis && analyzerRenderThread != nullptr)
+        analyzerRenderThread->drawFrame(g, responseArea);
+    
+    // Response curve, rasterised when it last changed:
+    if (responseCurveImage.isValid())
+        g.drawImage(responseCurveImage, getLocalBounds().toFloat());
+    
     g.setColour(Colours::orange);
     g.drawRoundedRectangle(getRenderArea().toFloat(), 4.f, 1.f);
-        
-    // Outline colour:
-        
-    g.setColour(Colours::white);
-        
-    // Draw response curve:
-    g.strokePath(responseCurve, PathStrokeType(2.f));
+}
+
+void ResponseCurveComponent::updateAnalysisSize()
+{
+    auto analysisArea = getAnalysisArea();
+    
+    if (analyzerRenderThread != nullptr)
+        analyzerRenderThread->setAnalysisSize(juce::roundToInt((float) analysisArea.getWidth() * displayScale),
+                                              juce::roundToInt((float) analysisArea.getHeight() * displayScale),
+                                              displayScale);
+}
+
+void ResponseCurveComponent::mouseDoubleClick(const juce::MouseEvent&)
+{
+    if (onDoubleClick)
+        onDoubleClick();
 }
 
 void ResponseCurveComponent::resized()
@@ -685,6 +1223,13 @@ void ResponseCurveComponent::resized()
         
         g.drawFittedText(str, r, juce::Justification::centred, 1);
     }
+    
+    updateAnalysisSize();
+    
+    // The pixel frequency grid follows the width of the analysis area, so every band needs re-evaluating
+    // (whether from the parameters or a preset slot):
+    hasCachedChainSettings = false;
+    updateChain();
 }
 
 juce::Rectangle<int> ResponseCurveComponent::getRenderArea()
@@ -712,31 +1257,319 @@ juce::Rectangle<int> ResponseCurveComponent::getAnalysisArea()
 }
     
 
+//==============================================================================
+void LoadMeterOverlay::visibilityChanged()
+{
+    if (isVisible())
+        startTimerHz(4);
+    else
+        stopTimer();
+}
+
+void LoadMeterOverlay::paint(juce::Graphics& g)
+{
+    using namespace juce;
+    
+    g.setColour(Colours::black.withAlpha(0.7f));
+    g.fillRoundedRectangle(getLocalBounds().toFloat(), 3.f);
+    
+    auto formatLine = [](const String& name, const LoadMeter& meter)
+    {
+        auto stats = meter.getStats();
+        auto percent = [](double load) { return String(load * 100.0, 1).paddedLeft(' ', 5) + "%"; };
+        
+        return name.paddedRight(' ', 9)
+             + "last" + percent(stats.last)
+             + "  mean" + percent(stats.mean)
+             + "  p99" + percent(stats.p99)
+             + "  worst" + percent(stats.worst);
+    };
+    
+    g.setColour(Colours::white);
+    g.setFont(Font(Font::getDefaultMonospacedFontName(), 11.f, Font::plain));
+    
+    // Capture-to-paint latency of the analyser's frames:
+    auto latency = audioProcessor.analyzerLatency.getStats(AnalyzerLatency::Painted);
+    auto ms = [](double value) { return String(value, 1).paddedLeft(' ', 6) + "ms"; };
+    
+    auto latencyLine = String("Latency").paddedRight(' ', 9)
+                     + "last" + ms(latency.lastMs)
+                     + "  p50" + ms(latency.p50Ms)
+                     + "  p99" + ms(latency.p99Ms);
+    
+    auto bounds = getLocalBounds().reduced(4, 2);
+    auto lineHeight = bounds.getHeight() / 4;
+    
+    g.drawFittedText(formatLine("DSP", audioProcessor.dspLoad), bounds.removeFromTop(lineHeight), Justification::centredLeft, 1);
+    g.drawFittedText(formatLine("Analyser", audioProcessor.analyzerLoad), bounds.removeFromTop(lineHeight), Justification::centredLeft, 1);
+    g.drawFittedText(formatLine("Paint", audioProcessor.paintLoad), bounds.removeFromTop(lineHeight), Justification::centredLeft, 1);
+    g.drawFittedText(latencyLine, bounds, Justification::centredLeft, 1);
+}
+
+//==============================================================================
+PresetSlotsComponent::PresetSlotsComponent(SimpleEQAudioProcessor& p):
+audioProcessor(p),
+presetSlots(p.presetSlots)
+{
+    for (int i = 0; i < PresetSlots::numSlots; ++i)
+    {
+        auto& button = slotButtons[(size_t) i];
+        
+        button.setButtonText(juce::String::charToString((juce::juce_wchar) ('A' + i)));
+        button.setColour(juce::TextButton::buttonOnColourId, juce::Colour(0u, 172u, 1u));
+        button.onClick = [this, i] { slotClicked(i); };
+        addAndMakeVisible(button);
+        
+        morphTargetBox.addItem("to " + button.getButtonText(), i + 1);
+    }
+    
+    storeButton.onClick = [this] { storeParameters(presetSlots.getSelectedSlot()); };
+    addAndMakeVisible(storeButton);
+    
+    morphTargetBox.setTextWhenNothingSelected("to -");
+    morphTargetBox.onChange = [this] { updateMorph(); };
+    addAndMakeVisible(morphTargetBox);
+    
+    morphSlider.setRange(0.0, 1.0);
+    morphSlider.onValueChange = [this] { updateMorph(); };
+    addAndMakeVisible(morphSlider);
+    
+    refresh();
+    startTimerHz(10);
+}
+
+void PresetSlotsComponent::resized()
+{
+    auto bounds = getLocalBounds();
+    
+    for (auto& button : slotButtons)
+    {
+        button.setBounds(bounds.removeFromLeft(24));
+        bounds.removeFromLeft(2);
+    }
+    
+    bounds.removeFromLeft(4);
+    storeButton.setBounds(bounds.removeFromLeft(44));
+    
+    bounds.removeFromLeft(4);
+    morphTargetBox.setBounds(bounds.removeFromLeft(56));
+    
+    bounds.removeFromLeft(4);
+    morphSlider.setBounds(bounds);
+}
+
+void PresetSlotsComponent::timerCallback()
+{
+    if (presetSlots.getChangeCount() != changeCount)
+        refresh();
+}
+
+void PresetSlotsComponent::slotClicked(int slot)
+{
+    if (! presetSlots.isSlotStored(slot))
+        storeParameters(slot);
+    else
+        presetSlots.select(presetSlots.getSelectedSlot() == slot ? PresetSlots::noSlot : slot);
+    
+    refresh();
+}
+
+void PresetSlotsComponent::storeParameters(int slot)
+{
+    // With no slot selected, into the first empty one (or the first):
+    if (slot == PresetSlots::noSlot)
+    {
+        slot = 0;
+        
+        for (int i = PresetSlots::numSlots - 1; i >= 0; --i)
+            if (! presetSlots.isSlotStored(i))
+                slot = i;
+    }
+    
+    presetSlots.store(slot, getChainSettings(audioProcessor.parameterHandles));
+    presetSlots.select(slot);
+    
+    refresh();
+}
+
+void PresetSlotsComponent::updateMorph()
+{
+    presetSlots.setMorph(morphTargetBox.getSelectedId() - 1, (float) morphSlider.getValue());
+}
+
+void PresetSlotsComponent::refresh()
+{
+    using namespace juce;
+    
+    changeCount = presetSlots.getChangeCount();
+    
+    const auto selectedSlot = presetSlots.getSelectedSlot();
+    
+    for (int i = 0; i < PresetSlots::numSlots; ++i)
+    {
+        auto& button = slotButtons[(size_t) i];
+        
+        button.setToggleState(i == selectedSlot, dontSendNotification);
+        
+        // Empty slots are dimmed:
+        button.setColour(TextButton::textColourOffId, presetSlots.isSlotStored(i) ? Colours::white : Colours::dimgrey);
+    }
+    
+    // (noSlot -> id 0, i.e. nothing selected)
+    morphTargetBox.setSelectedId(presetSlots.getMorphTargetSlot() + 1, dontSendNotification);
+    morphSlider.setValue(presetSlots.getMorphAmount(), dontSendNotification);
+    
+    // Morphing is from the selected slot:
+    morphTargetBox.setEnabled(selectedSlot != PresetSlots::noSlot);
+    morphSlider.setEnabled(selectedSlot != PresetSlots::noSlot);
+}
+
+//==============================================================================
+ExtraBandsComponent::ExtraBandsComponent(SimpleEQAudioProcessor& p):
+audioProcessor(p)
+{
+    for (int i = 0; i < Parameters::numExtraBands; ++i)
+        bandBox.addItem(Parameters::getBandName(i), i + 1);
+    
+    // (in the parameters' choice order, as the attachments expect)
+    typeBox.addItemList(Parameters::getFilterTypeChoices(), 1);
+    slopeBox.addItemList(Parameters::getSlopeChoices(), 1);
+    
+    bandBox.onChange = [this] { showBand(bandBox.getSelectedId() - 1); };
+    typeBox.onChange = [this] { updateEnablement(); };
+    bypassButton.onClick = [this] { updateEnablement(); };
+    
+    bypassButton.setLookAndFeel(&lnf.get());
+    
+    addAndMakeVisible(bandBox);
+    addAndMakeVisible(typeBox);
+    addAndMakeVisible(slopeBox);
+    addAndMakeVisible(bypassButton);
+    
+    bandBox.setSelectedId(1);
+}
+
+ExtraBandsComponent::~ExtraBandsComponent()
+{
+    bypassButton.setLookAndFeel(nullptr);
+}
+
+void ExtraBandsComponent::showBand(int extraBand)
+{
+    using namespace Parameters;
+    
+    auto& apvts = audioProcessor.apvts;
+    auto& handles = audioProcessor.parameterHandles;
+    
+    auto parameter = [extraBand](BandField field) { return getBandParameter(extraBand, field); };
+    
+    // Detach from the previous band before the sliders go:
+    bypassButtonAttachment.reset();
+    typeBoxAttachment.reset();
+    slopeBoxAttachment.reset();
+    freqSliderAttachment.reset();
+    gainSliderAttachment.reset();
+    qualitySliderAttachment.reset();
+    
+    freqSlider = std::make_unique<RotarySliderWithLabels>(handles.getParameter(parameter(BandFreq)), "Hz");
+    gainSlider = std::make_unique<RotarySliderWithLabels>(handles.getParameter(parameter(BandGain)), "dB");
+    qualitySlider = std::make_unique<RotarySliderWithLabels>(handles.getParameter(parameter(BandQuality)), "");
+    
+    freqSlider->labels.add({0.f, "20Hz"});
+    freqSlider->labels.add({1.f, "20KHz"});
+    
+    gainSlider->labels.add({0.f, "-24dB"});
+    gainSlider->labels.add({1.f, "+24dB"});
+    
+    qualitySlider->labels.add({0.f, "0.1"});
+    qualitySlider->labels.add({1.f, "10"});
+    
+    addAndMakeVisible(*freqSlider);
+    addAndMakeVisible(*gainSlider);
+    addAndMakeVisible(*qualitySlider);
+    
+    bypassButtonAttachment = std::make_unique<APVTS::ButtonAttachment>(apvts, getID(parameter(BandBypassed)), bypassButton);
+    typeBoxAttachment = std::make_unique<APVTS::ComboBoxAttachment>(apvts, getID(parameter(BandFilterType)), typeBox);
+    slopeBoxAttachment = std::make_unique<APVTS::ComboBoxAttachment>(apvts, getID(parameter(BandSlope)), slopeBox);
+    freqSliderAttachment = std::make_unique<APVTS::SliderAttachment>(apvts, getID(parameter(BandFreq)), *freqSlider);
+    gainSliderAttachment = std::make_unique<APVTS::SliderAttachment>(apvts, getID(parameter(BandGain)), *gainSlider);
+    qualitySliderAttachment = std::make_unique<APVTS::SliderAttachment>(apvts, getID(parameter(BandQuality)), *qualitySlider);
+    
+    updateEnablement();
+    resized();
+}
+
+void ExtraBandsComponent::updateEnablement()
+{
+    const auto bypassed = bypassButton.getToggleState();
+    const auto type = static_cast<BandType>(typeBox.getSelectedItemIndex());
+    const auto isCut = type == BandType::LowCut || type == BandType::HighCut;
+    
+    typeBox.setEnabled(! bypassed);
+    slopeBox.setEnabled(! bypassed && isCut);
+    
+    if (freqSlider != nullptr)
+    {
+        freqSlider->setEnabled(! bypassed);
+        gainSlider->setEnabled(! bypassed && ! isCut);
+        qualitySlider->setEnabled(! bypassed && ! isCut);
+    }
+}
+
+void ExtraBandsComponent::resized()
+{
+    auto bounds = getLocalBounds();
+    
+    // Band and bypass, then type and slope, down the left; the knobs share the rest:
+    auto selectionArea = bounds.removeFromLeft(90).reduced(2, 4);
+    bypassButton.setBounds(selectionArea.removeFromTop(25));
+    selectionArea.removeFromTop(4);
+    bandBox.setBounds(selectionArea.removeFromTop(24));
+    
+    auto typeArea = bounds.removeFromLeft(100).reduced(2, 4);
+    typeArea.removeFromTop(6);
+    typeBox.setBounds(typeArea.removeFromTop(24));
+    typeArea.removeFromTop(6);
+    slopeBox.setBounds(typeArea.removeFromTop(24));
+    
+    if (freqSlider == nullptr)
+        return;
+    
+    const auto sliderWidth = bounds.getWidth() / 3;
+    freqSlider->setBounds(bounds.removeFromLeft(sliderWidth));
+    gainSlider->setBounds(bounds.removeFromLeft(sliderWidth));
+    qualitySlider->setBounds(bounds);
+}
+
 //==============================================================================
 SimpleEQAudioProcessorEditor::SimpleEQAudioProcessorEditor (SimpleEQAudioProcessor& p)
     : AudioProcessorEditor (&p), audioProcessor (p),
 // Initialise response curve and slider parameter attachments:
-peakFreqSlider(*audioProcessor.apvts.getParameter("Peak Freq"), "Hz"),
-peakGainSlider(*audioProcessor.apvts.getParameter("Peak Gain"), "dB"),
-peakQualitySlider(*audioProcessor.apvts.getParameter("Peak Quality"), ""),
-lowCutFreqSlider(*audioProcessor.apvts.getParameter("LowCut Freq"), "Hz"),
-highCutFreqSlider(*audioProcessor.apvts.getParameter("HighCut Freq"), "Hz"),
-lowCutSlopeSlider(*audioProcessor.apvts.getParameter("LowCut Slope"), "dB/Oct"),
-highCutSlopeSlider(*audioProcessor.apvts.getParameter("HighCut Slope"), "dB/Oct"),
+peakFreqSlider(audioProcessor.parameterHandles.getParameter(Parameters::PeakFreq), "Hz"),
+peakGainSlider(audioProcessor.parameterHandles.getParameter(Parameters::PeakGain), "dB"),
+peakQualitySlider(audioProcessor.parameterHandles.getParameter(Parameters::PeakQuality), ""),
+lowCutFreqSlider(audioProcessor.parameterHandles.getParameter(Parameters::LowCutFreq), "Hz"),
+highCutFreqSlider(audioProcessor.parameterHandles.getParameter(Parameters::HighCutFreq), "Hz"),
+lowCutSlopeSlider(audioProcessor.parameterHandles.getParameter(Parameters::LowCutSlope), "dB/Oct"),
+highCutSlopeSlider(audioProcessor.parameterHandles.getParameter(Parameters::HighCutSlope), "dB/Oct"),
 
 responseCurveComponent(audioProcessor),
-peakFreqSliderAttachment(audioProcessor.apvts, "Peak Freq", peakFreqSlider),
-peakGainSliderAttachment(audioProcessor.apvts, "Peak Gain", peakGainSlider),
-peakQualitySliderAttachment(audioProcessor.apvts, "Peak Quality", peakQualitySlider),
-lowCutFreqSliderAttachment(audioProcessor.apvts, "LowCut Freq", lowCutFreqSlider),
-highCutFreqSliderAttachment(audioProcessor.apvts, "HighCut Freq", highCutFreqSlider),
-lowCutSlopeSliderAttachment(audioProcessor.apvts, "LowCut Slope", lowCutSlopeSlider),
-highCutSlopeSliderAttachment(audioProcessor.apvts, "HighCut Slope", highCutSlopeSlider),
-
-lowcutBypassButtonAttachment(audioProcessor.apvts, "LowCut Bypassed", lowcutBypassButton),
-highcutBypassButtonAttachment(audioProcessor.apvts, "HighCut Bypassed", highcutBypassButton),
-peakBypassButtonAttachment(audioProcessor.apvts, "Peak Bypassed", peakBypassButton),
-analyserEnabledButtonAttachment(audioProcessor.apvts, "Analyser Enabled", analyserEnabledButton)
+peakFreqSliderAttachment(audioProcessor.apvts, Parameters::getID(Parameters::PeakFreq), peakFreqSlider),
+peakGainSliderAttachment(audioProcessor.apvts, Parameters::getID(Parameters::PeakGain), peakGainSlider),
+peakQualitySliderAttachment(audioProcessor.apvts, Parameters::getID(Parameters::PeakQuality), peakQualitySlider),
+lowCutFreqSliderAttachment(audioProcessor.apvts, Parameters::getID(Parameters::LowCutFreq), lowCutFreqSlider),
+highCutFreqSliderAttachment(audioProcessor.apvts, Parameters::getID(Parameters::HighCutFreq), highCutFreqSlider),
+lowCutSlopeSliderAttachment(audioProcessor.apvts, Parameters::getID(Parameters::LowCutSlope), lowCutSlopeSlider),
+highCutSlopeSliderAttachment(audioProcessor.apvts, Parameters::getID(Parameters::HighCutSlope), highCutSlopeSlider),
+
+presetSlotsComponent(audioProcessor),
+extraBandsComponent(audioProcessor),
+lowcutBypassButtonAttachment(audioProcessor.apvts, Parameters::getID(Parameters::LowCutBypassed), lowcutBypassButton),
+highcutBypassButtonAttachment(audioProcessor.apvts, Parameters::getID(Parameters::HighCutBypassed), highcutBypassButton),
+peakBypassButtonAttachment(audioProcessor.apvts, Parameters::getID(Parameters::PeakBypassed), peakBypassButton),
+analyserEnabledButtonAttachment(audioProcessor.apvts, Parameters::getID(Parameters::AnalyserEnabled), analyserEnabledButton),
+svfTopologyButtonAttachment(audioProcessor.apvts, Parameters::getID(Parameters::SvfTopology), svfTopologyButton),
+loadMeterOverlay(audioProcessor)
 {
     // Make sure that before the constructor has finished, you've set the
     // editor's size to whatever you need it to be.
@@ -770,10 +1603,19 @@ analyserEnabledButtonAttachment(audioProcessor.apvts, "Analyser Enabled", analys
         addAndMakeVisible(comp);
     }
     
-    lowcutBypassButton.setLookAndFeel(&lnf);
-    highcutBypassButton.setLookAndFeel(&lnf);
-    peakBypassButton.setLookAndFeel(&lnf);
-    analyserEnabledButton.setLookAndFeel(&lnf);
+    // Load meters, on top of everything else (hidden until toggled):
+    addChildComponent(loadMeterOverlay);
+    
+    responseCurveComponent.onDoubleClick = [this]
+    {
+        setLoadMeterOverlayVisible(! loadMeterOverlay.isVisible());
+    };
+    
+    lowcutBypassButton.setLookAndFeel(&lnf.get());
+    highcutBypassButton.setLookAndFeel(&lnf.get());
+    peakBypassButton.setLookAndFeel(&lnf.get());
+    analyserEnabledButton.setLookAndFeel(&lnf.get());
+    svfTopologyButton.setLookAndFeel(&lnf.get());
     
     // Enable/disable sliders based upon bypass state:
     
@@ -824,8 +1666,10 @@ analyserEnabledButtonAttachment(audioProcessor.apvts, "Analyser Enabled", analys
         }
     };
     
-    // Embiggen the editor window:
-    setSize(480, 500);
+    // Embiggen the editor window (the extra bands' strip along the bottom included):
+    setSize(480, 580);
+    
+    constructionTimeMs = juce::Time::getMillisecondCounterHiRes() - constructionStartMs;
 }
 
 
@@ -836,6 +1680,7 @@ SimpleEQAudioProcessorEditor::~SimpleEQAudioProcessorEditor()
     highcutBypassButton.setLookAndFeel(nullptr);
     peakBypassButton.setLookAndFeel(nullptr);
     analyserEnabledButton.setLookAndFeel(nullptr);
+    svfTopologyButton.setLookAndFeel(nullptr);
 }
 
 //==============================================================================
@@ -848,6 +1693,10 @@ void SimpleEQAudioProcessorEditor::paint (juce::Graphics& g)
     // Black background:
     g.fillAll(Colours::black);
     
+    // The children (sliders, response curve) are painted right after this, as part of the same frame:
+    if (timeToFirstPaintMs == 0.0)
+        timeToFirstPaintMs = Time::getMillisecondCounterHiRes() - constructionStartMs;
+    
 //    g.setColour (juce::Colours::white);
 //    g.setFont (15.0f);
 //    g.drawFittedText ("Hello World!", getLocalBounds(), juce::Justification::centred, 1);
@@ -872,14 +1721,26 @@ void SimpleEQAudioProcessorEditor::resized()
     
     analyserEnabledButton.setBounds(analyserEnabledArea);
     
+    // The filter topology switch mirrors it, at the top right:
+    svfTopologyButton.setBounds(analyserEnabledArea.withX(getWidth() - analyserEnabledArea.getRight()));
+    
+    // The preset slots fill the space between them:
+    presetSlotsComponent.setBounds(analyserEnabledArea.withX(analyserEnabledArea.getRight() + 5)
+                                                      .withRight(svfTopologyButton.getX() - 5));
+    
     bounds.removeFromTop(5);
     
+    // The extra bands along the bottom, so the rest lays out as it did without them:
+    extraBandsComponent.setBounds(bounds.removeFromBottom(80));
+    
     // Response area = Some height ratio down from top (the rectangle in which the response curve will be situated):
     float hRatio = 25.f / 100.f;
     auto responseArea = bounds.removeFromTop(bounds.getHeight() * hRatio);
     
     responseCurveComponent.setBounds(responseArea);
     
+    loadMeterOverlay.setBounds(responseArea.reduced(16, 10).removeFromTop(64).withWidth(300));
+    
     // offset current bounds a few pixels below bottom boundary of responseArea:
     bounds.removeFromTop(5);
     
@@ -925,6 +1786,9 @@ std::vector<juce::Component*> SimpleEQAudioProcessorEditor::getComps()
         &lowcutBypassButton,
         &highcutBypassButton,
         &peakBypassButton,
-        &analyserEnabledButton
+        &analyserEnabledButton,
+        &svfTopologyButton,
+        &presetSlotsComponent,
+        &extraBandsComponent
     };
 }
@@ -10,6 +10,13 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "MagnitudeResponse.h"
+
+#include <map>
+#include <tuple>
+
+// Headless frame-time benchmark (Benchmarks/Source): steps the analyser and the response curve itself.
+struct ResponseCurveBenchmark;
 
 enum FFTOrder
 {
@@ -18,6 +25,80 @@ enum FFTOrder
     order8192 = 13
 };
 
+/**
+ Maps the bins of a spectrum to the pixel columns they fall into.
+ Only columns that receive at least one bin are stored, each with its (contiguous) bin range.
+ Immutable once built, so one map can be shared by every analyser with the same width and bins.
+ */
+struct BinToPixelMap
+{
+    struct Column
+    {
+        int x;
+        int firstBin, lastBin; // [firstBin, lastBin)
+    };
+
+    BinToPixelMap(const std::vector<float>& binFrequencies, int width)
+    {
+        numBins = (int)binFrequencies.size();
+        topFrequency = numBins > 0 ? binFrequencies.back() : 0.f;
+        mappedWidth = width;
+
+        for( int binNum = 0; binNum < numBins; ++binNum )
+        {
+            auto binFreq = binFrequencies[binNum];
+
+            // Bins outside 20 Hz - 20 kHz fall outside the display:
+            if( binFreq < 20.f || binFreq > 20000.f )
+                continue;
+
+            auto normalizedBinX = juce::mapFromLog10(binFreq, 20.f, 20000.f);
+            int binX = juce::jmin(width - 1, (int)std::floor(normalizedBinX * width));
+
+            // Bin frequencies are ascending, so a column's bins are contiguous:
+            if( !columns.empty() && columns.back().x == binX )
+                columns.back().lastBin = binNum + 1;
+            else
+                columns.push_back({ binX, binNum, binNum + 1 });
+        }
+    }
+
+    // The bin frequencies change with the FFT size and the sample rate:
+    bool matches(const std::vector<float>& binFrequencies, int width) const
+    {
+        return width == mappedWidth
+            && (int)binFrequencies.size() == numBins
+            && (numBins == 0 || binFrequencies.back() == topFrequency);
+    }
+
+    const std::vector<Column>& getColumns() const { return columns; }
+private:
+    std::vector<Column> columns;
+    int numBins = 0, mappedWidth = 0;
+    float topFrequency = 0.f;
+};
+
+/**
+ Process-wide cache of the immutable analyser resources (FFT plans, windowing tables and
+ bin-to-pixel maps), shared by every PathProducer of every plugin instance.
+ Access it through a juce::SharedResourcePointer, which keeps it alive while any instance uses it.
+ Each resource is handed out as a shared_ptr, and dropped from the cache once nobody holds it anymore.
+ */
+struct SharedAnalyzerResources
+{
+    std::shared_ptr<juce::dsp::FFT> getFFT(int order);
+    std::shared_ptr<juce::dsp::WindowingFunction<float>> getBlackmanHarrisWindow(int size);
+    std::shared_ptr<const BinToPixelMap> getBinToPixelMap(const std::vector<float>& binFrequencies, int width);
+private:
+    juce::CriticalSection lock;
+
+    std::map<int, std::weak_ptr<juce::dsp::FFT>> ffts;
+    std::map<int, std::weak_ptr<juce::dsp::WindowingFunction<float>>> windows;
+
+    // Keyed by width, number of bins and the top bin frequency (which follows the FFT size and sample rate):
+    std::map<std::tuple<int, int, float>, std::weak_ptr<const BinToPixelMap>> binToPixelMaps;
+};
+
 template<typename BlockType>
 struct FFTDataGenerator
 {
@@ -57,15 +138,15 @@ struct FFTDataGenerator
 
     void changeOrder(FFTOrder newOrder)
     {
-        // When you change order, recreate the window, forwardFFT, fifo, fftData.
+        // When you change order, fetch the window and forwardFFT, recreate the fifo, fftData.
         // Also reset the fifoIndex.
-        // Things that need recreating should be created on the heap via std::make_unique<>
+        // The window and forwardFFT are immutable, and shared with every other analyser using this order.
 
         order = newOrder;
         auto fftSize = getFFTSize();
 
-        forwardFFT = std::make_unique<juce::dsp::FFT>(order);
-        window = std::make_unique<juce::dsp::WindowingFunction<float>>(fftSize, juce::dsp::WindowingFunction<float>::blackmanHarris);
+        forwardFFT = sharedResources->getFFT(order);
+        window = sharedResources->getBlackmanHarrisWindow(fftSize);
 
         fftData.clear();
         fftData.resize(fftSize * 2, 0);
@@ -80,79 +161,261 @@ struct FFTDataGenerator
 private:
     FFTOrder order;
     BlockType fftData;
-    std::unique_ptr<juce::dsp::FFT> forwardFFT;
-    std::unique_ptr<juce::dsp::WindowingFunction<float>> window;
+    juce::SharedResourcePointer<SharedAnalyzerResources> sharedResources;
+    std::shared_ptr<juce::dsp::FFT> forwardFFT;
+    std::shared_ptr<juce::dsp::WindowingFunction<float>> window;
 
     Fifo<BlockType> fftDataFifo;
 };
 
+/**
+ Runs an FFTDataGenerator on octave-spaced, decimated copies of the incoming audio and
+ stitches the results into one spectrum, ordered by ascending frequency.
+
+ Level 0 runs at the host sample rate and covers [fs/8, fs/2].
+ Every further level is low-passed and decimated by 2, and covers the octave below the
+ previous level; the last level also covers everything down to DC.
+ With 3 levels of 2048-point FFTs, the bass gets the resolution of an 8192-point FFT.
+ */
+template<typename BlockType>
+struct MultiResolutionFFTDataGenerator
+{
+    static constexpr int numLevels = 3;
+
+    void prepare(FFTOrder newOrder, double sampleRate, float negativeInfinity)
+    {
+        auto levelSampleRate = sampleRate;
+
+        for (int level = 0; level < numLevels; ++level)
+        {
+            auto& l = levels[level];
+
+            l.generator.changeOrder(newOrder);
+
+            const auto fftSize = l.generator.getFFTSize();
+
+            l.rollingBuffer.setSize(1, fftSize, false, true, true);
+            l.rollingBuffer.clear();
+
+            // Until a level has produced its first frame, display the noise floor:
+            l.spectrum.assign(fftSize * 2, negativeInfinity);
+            l.decimationPhase = 0;
+
+            // Each level after the first gets its own anti-aliasing filter, designed at the
+            // rate of the level feeding it. Cutoff at 0.15 * fs keeps aliases > 100 dB down
+            // in the octave this level contributes:
+            if (level > 0)
+            {
+                auto inputSampleRate = levelSampleRate * 2.0;
+
+                juce::dsp::ProcessSpec spec;
+                spec.sampleRate = inputSampleRate;
+                spec.maximumBlockSize = (juce::uint32) fftSize;
+                spec.numChannels = 1;
+
+                l.decimationFilter.prepare(spec);
+
+                auto coefficients = juce::dsp::FilterDesign<float>::designIIRLowpassHighOrderButterworthMethod(0.15f * (float) inputSampleRate, inputSampleRate, 8);
+                updateCutFilter(l.decimationFilter, coefficients, Slope::Slope_48);
+            }
+
+            // Range of bins (by index) this level contributes to the stitched spectrum:
+            const bool isLastLevel = (level == numLevels - 1);
+            l.firstBin = isLastLevel ? 0 : fftSize / 8;
+            l.lastBin = (level == 0) ? fftSize / 2 : fftSize / 4;
+            l.binWidth = (float) (levelSampleRate / (double) fftSize);
+
+            levelSampleRate *= 0.5;
+        }
+
+        // Lowest frequencies (last level) first:
+        binFrequencies.clear();
+        for (int level = numLevels - 1; level >= 0; --level)
+        {
+            auto& l = levels[level];
+            for (int bin = l.firstBin; bin < l.lastBin; ++bin)
+                binFrequencies.push_back(bin * l.binWidth);
+        }
+
+        stitchedData.assign(binFrequencies.size(), negativeInfinity);
+        stitchedDataFifo.prepare(stitchedData.size());
+
+        blockCount = 0;
+    }
+
+    /**
+     feeds a block of audio through the cascade and pushes a stitched spectrum.
+     Level N only runs its FFT on every 2^N-th block, as its buffer advances more slowly.
+     */
+    void produceFFTDataForRendering(const juce::AudioBuffer<float>& audioData, const float negativeInfinity)
+    {
+        auto* input = audioData.getReadPointer(0);
+        auto numSamples = audioData.getNumSamples();
+
+        for (int level = 0; level < numLevels; ++level)
+        {
+            auto& l = levels[level];
+
+            if (level > 0)
+            {
+                // Low-pass a copy of the previous level's samples, then keep every other one:
+                l.decimationBuffer.setSize(1, numSamples, false, false, true);
+                l.decimationBuffer.copyFrom(0, 0, input, numSamples);
+
+                auto block = juce::dsp::AudioBlock<float>(l.decimationBuffer).getSubBlock(0, (size_t) numSamples);
+                l.decimationFilter.process(juce::dsp::ProcessContextReplacing<float>(block));
+
+                auto* data = l.decimationBuffer.getWritePointer(0);
+                int numDecimated = 0;
+
+                for (int i = 0; i < numSamples; ++i)
+                {
+                    if (l.decimationPhase == 0)
+                        data[numDecimated++] = data[i];
+
+                    l.decimationPhase ^= 1;
+                }
+
+                input = data;
+                numSamples = numDecimated;
+            }
+
+            pushIntoRollingBuffer(l.rollingBuffer, input, numSamples);
+
+            if ((blockCount & ((1 << level) - 1)) == 0)
+            {
+                l.generator.produceFFTDataForRendering(l.rollingBuffer, negativeInfinity);
+
+                while (l.generator.getNumAvailableFFTDataBlocks() > 0)
+                    l.generator.getFFTData(l.spectrum);
+            }
+        }
+
+        ++blockCount;
+
+        auto writeIndex = stitchedData.begin();
+        for (int level = numLevels - 1; level >= 0; --level)
+        {
+            auto& l = levels[level];
+            writeIndex = std::copy(l.spectrum.begin() + l.firstBin,
+                                   l.spectrum.begin() + l.lastBin,
+                                   writeIndex);
+        }
+
+        stitchedDataFifo.push(stitchedData);
+    }
+
+    //==============================================================================
+    int getNumAvailableFFTDataBlocks() const { return stitchedDataFifo.getNumAvailableForReading(); }
+    bool getFFTData(BlockType& fftData) { return stitchedDataFifo.pull(fftData); }
+
+    // Centre frequency (Hz) of each bin in the stitched spectrum:
+    const std::vector<float>& getBinFrequencies() const { return binFrequencies; }
+private:
+    struct Level
+    {
+        FFTDataGenerator<BlockType> generator;
+        CutFilter decimationFilter;
+        juce::AudioBuffer<float> rollingBuffer, decimationBuffer;
+        BlockType spectrum;
+        int decimationPhase = 0;
+        int firstBin = 0, lastBin = 0;
+        float binWidth = 0.f;
+    };
+
+    static void pushIntoRollingBuffer(juce::AudioBuffer<float>& buffer, const float* samples, int numSamples)
+    {
+        const auto size = buffer.getNumSamples();
+
+        // Blocks larger than the buffer only keep their most recent samples:
+        if (numSamples >= size)
+        {
+            buffer.copyFrom(0, 0, samples + numSamples - size, size);
+            return;
+        }
+
+        // shift the oldest content down, then copy the new block to the end:
+        juce::FloatVectorOperations::copy(buffer.getWritePointer(0, 0),
+                                          buffer.getReadPointer(0, numSamples),
+                                          size - numSamples);
+
+        juce::FloatVectorOperations::copy(buffer.getWritePointer(0, size - numSamples),
+                                          samples,
+                                          numSamples);
+    }
+
+    std::array<Level, numLevels> levels;
+    std::vector<float> binFrequencies;
+    BlockType stitchedData;
+    Fifo<BlockType> stitchedDataFifo;
+    juce::uint32 blockCount = 0;
+};
+
 template<typename PathType>
 struct AnalyzerPathGenerator
 {
     /*
-     converts 'renderData[]' into a juce::Path
+     converts 'renderData[]' into 'path' (cleared first, so its storage gets reused),
+     with one point per pixel column (the loudest bin in that column).
+     The path is generated directly in the coordinate space of 'fftBounds':
+     'negativeInfinity' maps to its bottom and 0 dB to its top.
      */
     void generatePath(const std::vector<float>& renderData,
+                      const std::vector<float>& binFrequencies,
                       juce::Rectangle<float> fftBounds,
-                      int fftSize,
-                      float binWidth,
-                      float negativeInfinity)
+                      float negativeInfinity,
+                      PathType& path)
     {
+        auto left = fftBounds.getX();
         auto top = fftBounds.getY();
-        auto bottom = fftBounds.getHeight();
-        auto width = fftBounds.getWidth();
+        auto bottom = fftBounds.getBottom();
+        int width = (int)fftBounds.getWidth();
 
-        int numBins = (int)fftSize / 2;
+        // Fetch another bin -> pixel mapping only when the bounds, FFT size or sample rate change:
+        if( binToPixelMap == nullptr || !binToPixelMap->matches(binFrequencies, width) )
+            binToPixelMap = sharedResources->getBinToPixelMap(binFrequencies, width);
+
+        const auto& columns = binToPixelMap->getColumns();
 
-        PathType p;
-        p.preallocateSpace(3 * (int)fftBounds.getWidth());
+        path.clear();
+        path.preallocateSpace(3 * ((int)columns.size() + 1));
 
         auto map = [bottom, top, negativeInfinity](float v)
         {
             return juce::jmap(v,
                               negativeInfinity, 0.f,
-                              float(bottom+10),   top);
+                              bottom,   top);
         };
 
-        auto y = map(renderData[0]);
-
-//        jassert( !std::isnan(y) && !std::isinf(y) );
-        if( std::isnan(y) || std::isinf(y) )
-            y = bottom;
-        
-        p.startNewSubPath(0, y);
-
-        const int pathResolution = 2; //you can draw line-to's every 'pathResolution' pixels.
+        bool startedPath = false;
 
-        for( int binNum = 1; binNum < numBins; binNum += pathResolution )
+        for( const auto& column : columns )
         {
-            y = map(renderData[binNum]);
+            // Peak of all bins that land on this column:
+            auto peak = *std::max_element(renderData.begin() + column.firstBin,
+                                          renderData.begin() + column.lastBin);
+            auto y = map(peak);
 
 //            jassert( !std::isnan(y) && !std::isinf(y) );
 
-            if( !std::isnan(y) && !std::isinf(y) )
+            if( std::isnan(y) || std::isinf(y) )
+                y = bottom;
+
+            if( !startedPath )
             {
-                auto binFreq = binNum * binWidth;
-                auto normalizedBinX = juce::mapFromLog10(binFreq, 20.f, 20000.f);
-                int binX = std::floor(normalizedBinX * width);
-                p.lineTo(binX, y);
+                path.startNewSubPath(left, y);
+                startedPath = true;
             }
-        }
 
-        pathFifo.push(p);
-    }
-
-    int getNumPathsAvailable() const
-    {
-        return pathFifo.getNumAvailableForReading();
-    }
+            path.lineTo(left + column.x, y);
+        }
 
-    bool getPath(PathType& path)
-    {
-        return pathFifo.pull(path);
+        if( !startedPath )
+            path.startNewSubPath(left, bottom);
     }
 private:
-    Fifo<PathType> pathFifo;
+    juce::SharedResourcePointer<SharedAnalyzerResources> sharedResources;
+    std::shared_ptr<const BinToPixelMap> binToPixelMap;
 };
 
 struct LookAndFeel : juce::LookAndFeel_V4
@@ -171,6 +434,16 @@ struct LookAndFeel : juce::LookAndFeel_V4
                           juce::ToggleButton &toggleButton,
                           bool shouldDrawButtonAsHighlighted,
                           bool shouldDrawButtonAsDown) override;
+
+private:
+    // Knob bodies (fill + outline) rendered once per physical size (i.e. per size and display scale)
+    // and enabled state; only the pointer and the value text are drawn on every paint:
+    std::map<std::tuple<int, int, bool>, juce::Image> knobBodies;
+    const juce::Image& getKnobBody(float width, float height, float scale, bool enabled);
+
+    // Unrotated pointers, centred on (0, 0), per knob radius and text height:
+    std::map<std::tuple<float, int>, juce::Path> knobPointers;
+    const juce::Path& getKnobPointer(float radius, int textHeight);
 };
 
 // Rotary Slider customisation:
@@ -182,9 +455,12 @@ struct RotarySliderWithLabels : juce::Slider
        juce::Slider(juce::Slider::SliderStyle::RotaryHorizontalVerticalDrag,
         juce::Slider::TextEntryBoxPosition::NoTextBox),
         param(&rap),
+        // Resolve the parameter type once, rather than on every repaint:
+        choiceParam(dynamic_cast<juce::AudioParameterChoice*>(&rap)),
+        floatParam(dynamic_cast<juce::AudioParameterFloat*>(&rap)),
         suffix(unitSuffix)
     {
-        setLookAndFeel(&lnf);
+        setLookAndFeel(&lnf.get());
     }
     
     // unset LookAndFeel in destructor:
@@ -205,17 +481,24 @@ struct RotarySliderWithLabels : juce::Slider
     
     
     void paint(juce::Graphics& g) override; 
+    void resized() override;
     juce::Rectangle<int> getSliderBounds() const;
     int getTextHeight() const {return 14;}
     juce::String getDisplayString() const; 
     
 private:
     
-    // LookAndFeel instance:
-    LookAndFeel lnf;
+    // LookAndFeel instance, shared by every slider of every editor:
+    juce::SharedResourcePointer<LookAndFeel> lnf;
     // base class, with access to all relevant methods:
     juce::RangedAudioParameter* param;
+    juce::AudioParameterChoice* choiceParam;
+    juce::AudioParameterFloat* floatParam;
     juce::String suffix;
+    
+    // Positions of the min/max labels, recomputed on resize:
+    juce::Array<juce::Rectangle<int>> labelBounds;
+    void updateLabelBounds();
 
 };
 
@@ -230,32 +513,100 @@ struct PathProducer
            ca. 23 Hz bins (48000/2048).
            This results in low resultion for lower frequencies. Raising the no. of bins
            -> increase in resource (CPU) consumption.
+           Instead, 2048-point FFTs are run on decimated copies of the signal
+           (see MultiResolutionFFTDataGenerator), giving ca. 6 Hz bins in the bass.
+           The generator is prepared in process(), once the sample rate is known.
             */
-        leftChannelFFTDataGenerator.changeOrder(FFTOrder::order2048);
-        
-        // Initialise buffer at new size:
-        monoBuffer.setSize(1, leftChannelFFTDataGenerator.getFFTSize());
     }
+
+    // Returns true if a new path was produced:
+    bool process(juce::Rectangle<float> fftBounds, double sampleRate);
+
+    // The latest path, borrowed (only valid until the next call to process()):
+    const juce::Path& getPath() const {return leftChannelFFTPath;};
     
-    void process(juce::Rectangle<float> fftBounds, double sampleRate);
-    juce::Path getPath() {return leftChannelFFTPath;}; 
-    
+    // Stamp of the newest audio analysed so far, and when its buffer was pulled off the FIFO:
+    const FrameStamp& getFrameStamp() const { return frameStamp; }
+    juce::int64 getDequeuedTicks() const { return dequeuedTicks; }
+
 private:
     SingleChannelSampleFifo<SimpleEQAudioProcessor::BlockType>* leftChannelFifo;
-    
-    juce::AudioBuffer<float> monoBuffer;
-    
-    FFTDataGenerator<std::vector<float>> leftChannelFFTDataGenerator;
+
+    MultiResolutionFFTDataGenerator<std::vector<float>> leftChannelFFTDataGenerator;
+
+    double preparedSampleRate = 0.0;
     
     AnalyzerPathGenerator<juce::Path> pathProducer;
     
+    // Reused from frame to frame, to avoid reallocating on every call to process():
+    juce::AudioBuffer<float> incomingBuffer;
+    std::vector<float> fftData;
     juce::Path leftChannelFFTPath;
+    
+    FrameStamp frameStamp;
+    juce::int64 dequeuedTicks = 0;
+};
+
+/**
+ Runs both PathProducers on a background thread and rasterises their traces into a
+ double-buffered image, so that the message thread only has to blit it.
+ The thread sleeps until notify()'d (once per display refresh, by ResponseCurveComponent).
+ */
+struct AnalyzerRenderThread : juce::Thread
+{
+    AnalyzerRenderThread(SimpleEQAudioProcessor&);
+    ~AnalyzerRenderThread() override;
+    
+    void run() override;
+    
+    // Called from the message thread. The size is in physical pixels, 'scale' of them per logical pixel
+    // (the frames are rendered at the display's resolution):
+    void setAnalysisSize(int width, int height, float scale);
+    void setSampleRate(double sampleRate) { currentSampleRate.set(sampleRate); }
+    void setEnabled(bool enabled) { analysisEnabled.set(enabled); }
+    
+    // Returns true (once) if a new frame was rendered since the last call:
+    bool pullNewFrame();
+    
+    // Draws the most recent frame into 'area' (in logical pixels):
+    void drawFrame(juce::Graphics& g, juce::Rectangle<int> area);
+    
+private:
+    PathProducer leftPathProducer, rightPathProducer;
+    LoadMeter& analyzerLoad;
+    AnalyzerLatency& latency;
+    
+    juce::Atomic<int> analysisWidth { 0 }, analysisHeight { 0 };
+    juce::Atomic<float> analysisScale { 1.f };
+    juce::Atomic<double> currentSampleRate { 0.0 };
+    juce::Atomic<bool> analysisEnabled { true };
+    juce::Atomic<bool> newFrameAvailable { false };
+    
+    // The render thread draws into images[1 - frontImageIndex], then swaps under the lock.
+    // drawFrame() only reads images[frontImageIndex], and holds the lock while doing so:
+    juce::CriticalSection imageLock;
+    std::array<juce::Image, 2> images;
+    int frontImageIndex = 0;
+    
+    // The stamp of the frame in each image (also guarded by imageLock), and of the last one painted:
+    std::array<FrameStamp, 2> imageStamps;
+    juce::int64 lastPaintedSamplePosition = -1;
+    
+    void renderFrame(int width, int height, float scale, const FrameStamp& stamp);
+    
+    // Non anti-aliased polyline, 'thickness' pixels wide: each segment fills the span it covers in every
+    // column it crosses.
+    static void rasterizePolyline(juce::Image::BitmapData& bitmap,
+                                  const juce::Path& path,
+                                  juce::PixelARGB pixel,
+                                  int thickness);
+    
+    friend struct ResponseCurveBenchmark;
 };
 
 // Response curve as separate component (to avoid exceeding editor boundaries):
 struct ResponseCurveComponent: juce::Component,
-juce::AudioProcessorParameter::Listener,
-juce::Timer
+juce::AudioProcessorParameter::Listener
 {
     ResponseCurveComponent(SimpleEQAudioProcessor&);
     ~ResponseCurveComponent();
@@ -266,7 +617,11 @@ juce::Timer
     // Not relevant: empty implementation
     void parameterGestureChanged (int parameterIndex, bool gestureIsStarting) override {};
     
-    void timerCallback() override;
+    // Called once per display refresh (see vBlankAttachment):
+    void onVBlank();
+    
+    std::function<void()> onDoubleClick;
+    void mouseDoubleClick(const juce::MouseEvent&) override;
     
     void paint(juce::Graphics&) override;
     void resized() override;
@@ -274,6 +629,13 @@ juce::Timer
     void toggleAnalysisEnablement(bool enabled)
     {
         shouldShowFFTAnalysis = enabled;
+        
+        // (the analyser is only created on first use, see onVBlank())
+        if (analyzerRenderThread != nullptr)
+            analyzerRenderThread->setEnabled(enabled);
+        
+        // Draw (or clear) the analyser traces:
+        repaint(getRenderArea());
     }
     
 private:
@@ -283,9 +645,59 @@ private:
     juce::Atomic<bool> parametersChanged { false };
     
     MonoChain monoChain;
-    
+
     void updateChain();
+
+    // Settings/sample rate the cached magnitudes were computed for:
+    ChainSettings cachedChainSettings;
+    double cachedSampleRate = 0.0;
+    bool hasCachedChainSettings = false;
+
+    // Log-spaced frequency grid (one point per pixel column in the analysis area), with
+    // precomputed cos/sin terms for batch evaluation of the filter sections:
+    BiquadMagnitudeEvaluator magnitudeEvaluator;
+
+    // Per-band magnitudes (as gain) over the frequency grid, recomputed only when that band changes:
+    std::vector<double> lowCutMagnitudes, peakMagnitudes, highCutMagnitudes;
+
+    void updatePixelFrequencies();
+    void updateLowCutMagnitudes();
+    void updatePeakMagnitudes();
+    void updateHighCutMagnitudes();
+    
+    // Either cut's magnitudes, multiplied into 'magnitudes' (already sized to the grid):
+    void updateCutMagnitudes(bool isHighPass, float cutoff, Slope slope, std::vector<double>& magnitudes);
+    
+    // Every band's magnitudes from two preset slots' designs blended, as the biquads morph between them:
+    void updateBlendedMagnitudes(const PresetSlots::ActiveSettings& slotSettings);
+    
+    // The processor's extra bands (the fixed three stay off here), which follow the parameters whatever
+    // preset slot is selected, and their combined magnitudes over the grid:
+    BandEngine extraBands;
+    double extraBandsSampleRate = -1.0;
+    std::vector<double> extraBandMagnitudes;
+    
+    // Returns true if any extra band changed (and re-evaluates them if so, or if the grid did):
+    bool updateExtraBands();
+    void updateExtraBandMagnitudes();
+    
+    // The preset slots' change count the curve was last drawn for (a selected slot overrides the parameters):
+    int presetSlotsChangeCount = -1;
+
+    // Combined response curve, and its rasterised image (redrawn only when the curve changes):
+    juce::Path responseCurve;
+    juce::Image responseCurveImage;
     
+    // Physical pixels per logical pixel on the display last painted to, which the response curve and the
+    // analyser are rendered at (picked up in paint(), so a move to another display re-renders them):
+    float displayScale = 1.f;
+    
+    void updateAnalysisSize();
+
+    void updateResponseCurve();
+    void updateResponseCurvePath();
+    void strokeResponseCurve();
+
     // response curve grid: 
     juce::Image background;
     
@@ -294,13 +706,38 @@ private:
     // Area for actual response curve/grid lines: 
     juce::Rectangle<int> getAnalysisArea();
     
-    PathProducer leftPathProducer, rightPathProducer;
+    // Created the first time the analyser is shown, so that opening the editor doesn't wait for it:
+    std::unique_ptr<AnalyzerRenderThread> analyzerRenderThread;
     
     bool shouldShowFFTAnalysis = true;
     
+    // Paces repaints to the display refresh; only fires while the component is on screen:
+    juce::VBlankAttachment vBlankAttachment;
+    
+    friend struct ResponseCurveBenchmark;
 };
 
 //==============================================================================
+/**
+ Text overlay of the processor's load meters: last/mean/p99/worst, as a percentage of the time available,
+ and of the analyser's capture-to-paint latency.
+ Refreshes a few times a second, and only while visible.
+ */
+struct LoadMeterOverlay : juce::Component, juce::Timer
+{
+    LoadMeterOverlay(SimpleEQAudioProcessor& p) : audioProcessor(p)
+    {
+        setInterceptsMouseClicks(false, false);
+    }
+    
+    void paint(juce::Graphics& g) override;
+    void timerCallback() override { repaint(); }
+    void visibilityChanged() override;
+    
+private:
+    SimpleEQAudioProcessor& audioProcessor;
+};
+
 struct PowerButton : juce::ToggleButton {};
 struct AnalyserButton : juce::ToggleButton
 {
@@ -330,6 +767,74 @@ struct AnalyserButton : juce::ToggleButton
     juce::Path randomPath;    
 };
 
+// Switches the processor's low cut, peak and high cut between BandEngine's biquads and SvfChain (lit while the
+// SVFs are in use):
+struct TopologyButton : juce::ToggleButton {};
+
+/**
+ Controls for the processor's PresetSlots. Clicking a slot follows it (again, back to the parameters), or
+ stores the parameters into it if it's empty; "Store" stores them into the selected slot. The slider morphs
+ from the selected slot towards the slot picked in the box.
+ Polls the slots a few times a second, as a host restoring state changes them too.
+ */
+struct PresetSlotsComponent : juce::Component, juce::Timer
+{
+    PresetSlotsComponent(SimpleEQAudioProcessor&);
+    
+    void resized() override;
+    void timerCallback() override;
+    
+private:
+    SimpleEQAudioProcessor& audioProcessor;
+    PresetSlots& presetSlots;
+    
+    std::array<juce::TextButton, PresetSlots::numSlots> slotButtons;
+    juce::TextButton storeButton {"Store"};
+    juce::ComboBox morphTargetBox;
+    juce::Slider morphSlider {juce::Slider::LinearHorizontal, juce::Slider::NoTextBox};
+    
+    int changeCount = -1;
+    
+    void slotClicked(int slot);
+    void storeParameters(int slot);
+    void updateMorph();
+    void refresh();
+};
+
+/**
+ Controls for the processor's extra bands (Band 4 to Band 16), one band at a time: the box on the left picks
+ which. The power button bypasses the band, as it does the fixed ones (they start out bypassed, and cost nothing
+ while they are). The knobs and slope box are re-attached to whichever band is picked.
+ */
+struct ExtraBandsComponent : juce::Component
+{
+    ExtraBandsComponent(SimpleEQAudioProcessor&);
+    ~ExtraBandsComponent() override;
+    
+    void resized() override;
+    
+private:
+    SimpleEQAudioProcessor& audioProcessor;
+    
+    juce::ComboBox bandBox, typeBox, slopeBox;
+    PowerButton bypassButton;
+    std::unique_ptr<RotarySliderWithLabels> freqSlider, gainSlider, qualitySlider;
+    
+    using APVTS = juce::AudioProcessorValueTreeState;
+    
+    // (declared after what they're attached to, so they go first)
+    std::unique_ptr<APVTS::ButtonAttachment> bypassButtonAttachment;
+    std::unique_ptr<APVTS::ComboBoxAttachment> typeBoxAttachment, slopeBoxAttachment;
+    std::unique_ptr<APVTS::SliderAttachment> freqSliderAttachment, gainSliderAttachment, qualitySliderAttachment;
+    
+    juce::SharedResourcePointer<LookAndFeel> lnf;
+    
+    void showBand(int extraBand);
+    
+    // Only what the band's type uses is enabled, and nothing while it's bypassed:
+    void updateEnablement();
+};
+
 /**
 */
 class SimpleEQAudioProcessorEditor  : public juce::AudioProcessorEditor
@@ -342,8 +847,20 @@ public:
     //==============================================================================
     void paint (juce::Graphics&) override;
     void resized() override;
+    
+    // Editor-open latency probe (ms): from the start of construction to the end of the
+    // constructor, and to the end of the first paint() (0 until it has happened):
+    double getConstructionTimeMs() const { return constructionTimeMs; }
+    double getTimeToFirstPaintMs() const { return timeToFirstPaintMs; }
+    
+    // (also toggled by double-clicking the response curve)
+    void setLoadMeterOverlayVisible(bool shouldBeVisible) { loadMeterOverlay.setVisible(shouldBeVisible); }
 
 private:
+    // Initialised before any other member, so the probe covers their construction too:
+    const double constructionStartMs = juce::Time::getMillisecondCounterHiRes();
+    double constructionTimeMs = 0.0, timeToFirstPaintMs = 0.0;
+    
     // This reference is provided as a quick way for your editor to
     // access the processor object that created it.
     SimpleEQAudioProcessor& audioProcessor;
@@ -376,19 +893,30 @@ private:
     
     PowerButton lowcutBypassButton, highcutBypassButton, peakBypassButton;
     AnalyserButton analyserEnabledButton; 
+    TopologyButton svfTopologyButton;
+    
+    // Between the analyser and topology buttons:
+    PresetSlotsComponent presetSlotsComponent;
+    
+    // Along the bottom:
+    ExtraBandsComponent extraBandsComponent;
     
     using ButtonAttachment = APVTS::ButtonAttachment;
     
     ButtonAttachment lowcutBypassButtonAttachment,
                      highcutBypassButtonAttachment,
                      peakBypassButtonAttachment,
-                     analyserEnabledButtonAttachment;
+                     analyserEnabledButtonAttachment,
+                     svfTopologyButtonAttachment;
+    
+    // Hidden until asked for; sits on top of the response curve:
+    LoadMeterOverlay loadMeterOverlay;
     
     // Retrieve all sliders as a vector for ease of iteration through all sliders:
     std::vector<juce::Component*> getComps();
     
-    // LookAndFeel instance: 
-    LookAndFeel lnf;
+    // LookAndFeel instance (shared with the sliders, and with every other editor): 
+    juce::SharedResourcePointer<LookAndFeel> lnf;
     
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SimpleEQAudioProcessorEditor)
@@ -22,10 +22,15 @@ SimpleEQAudioProcessor::SimpleEQAudioProcessor()
                        )
 #endif
 {
+    // Add listener for each param:
+    for (auto param : getParameters())
+        param->addListener(this);
 }
 
 SimpleEQAudioProcessor::~SimpleEQAudioProcessor()
 {
+    for (auto param : getParameters())
+        param->removeListener(this);
 }
 
 //==============================================================================
@@ -96,22 +101,52 @@ void SimpleEQAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlo
     // Use this method as the place to do any pre-playback
     // initialisation that you need..
     
-    // prepare L/R channels of MonoChain (chain of filters):
-    juce::dsp::ProcessSpec spec;
-    
-    spec.maximumBlockSize = samplesPerBlock;
-    
-    spec.numChannels = 1;
-    
-    spec.sampleRate = sampleRate;
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+    
+    // Some hosts call this on every transport start (and the offline pipeline on every render), so only
+    // what the new spec actually changes gets redone:
+    if (preparedSampleRate <= 0.0)
+        lastPrepareKind = PrepareKind::Full;
+    else if (sampleRate != preparedSampleRate)
+        lastPrepareKind = PrepareKind::SampleRateChange;
+    else if (samplesPerBlock != preparedBlockSize)
+        lastPrepareKind = PrepareKind::BlockSizeChange;
+    else
+        lastPrepareKind = PrepareKind::Unchanged;
+    
+    // Whatever changed (if anything), playback starts again from silence:
+    bandEngine.reset();
+    svfChain.reset();
+    
+    // New rate, new designs (any made for this rate before come out of the cache):
+    if (lastPrepareKind == PrepareKind::Full || lastPrepareKind == PrepareKind::SampleRateChange)
+    {
+        // (the engine redesigns every band it holds at the new rate; the parameters are then applied on top)
+        bandEngine.prepare(sampleRate, 2);
+        svfChain.prepare(sampleRate, 2);
+        usingSvfTopology = parameterHandles.getBool(Parameters::SvfTopology);
+        
+        updateFilters();
+        updateExtraBands();
+        svfChain.finishGlides();
+        parametersChanged.set(false);
+        presetSlots.prepare(sampleRate, designCache);
+    }
     
-    leftChain.prepare(spec);
-    rightChain.prepare(spec);
+    // The analyser's buffers follow the block size (and anything captured at the old rate is dropped):
+    if (lastPrepareKind != PrepareKind::Unchanged)
+    {
+        dspLoad.reset();
+        analyzerLatency.reset();
+        
+        leftChannelFifo.prepare(samplesPerBlock);
+        rightChannelFifo.prepare(samplesPerBlock);
+    }
     
-    updateFilters();
+    preparedSampleRate = sampleRate;
+    preparedBlockSize = samplesPerBlock;
     
-    leftChannelFifo.prepare(samplesPerBlock);
-    rightChannelFifo.prepare(samplesPerBlock);
+    lastPrepareTimeMs = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks) * 1000.0;
     
     // Lambda function: takes a value, returns the sin (in radians):
 //    osc.initialise([](float x) {return std::sin(x);});
@@ -157,6 +192,8 @@ bool SimpleEQAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts)
 void SimpleEQAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
     juce::ScopedNoDenormals noDenormals;
+    const LoadMeter::ScopedMeasurement dspMeasurement(dspLoad, getSampleRate() > 0.0 ? buffer.getNumSamples() / getSampleRate() : 0.0);
+    
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
 
@@ -170,10 +207,6 @@ void SimpleEQAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juc
         buffer.clear (i, 0, buffer.getNumSamples());
     
  
-    // copied from prepareToPlay() for testing purposes:
-    
-    updateFilters();
-    
     juce::dsp::AudioBlock<float> block(buffer);
 
 // Test sine, for FFT spectrum analyser testing purposes:
@@ -182,14 +215,16 @@ void SimpleEQAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juc
 //    juce::dsp::ProcessContextReplacing<float> stereoContext(block);
 //    osc.process(stereoContext);
 //
-    auto leftBlock = block.getSingleChannelBlock(0);
-    auto rightBlock = block.getSingleChannelBlock(1);
+    // Coefficients only change when a parameter has (the SVF topology then glides to them within the block):
+    updateFiltersIfNeeded();
+    
+    juce::dsp::ProcessContextReplacing<float> context(block);
     
-    juce::dsp::ProcessContextReplacing<float> leftContext(leftBlock);
-    juce::dsp::ProcessContextReplacing<float> rightContext(rightBlock);
+    // (in SVF mode the engine's fixed bands are off, and it runs just the extra bands)
+    if (usingSvfTopology)
+        svfChain.process(context);
     
-    leftChain.process(leftContext);
-    rightChain.process(rightContext);
+    bandEngine.process(context);
     
     leftChannelFifo.update(buffer);
     rightChannelFifo.update(buffer);
@@ -222,6 +257,13 @@ juce::AudioProcessorEditor* SimpleEQAudioProcessor::createEditor()
 }
 
 //==============================================================================
+// Binary state chunk: magic, format version, parameter count, then each parameter's raw
+// (non-normalised) value as a float, in Parameters::Index order (the extra bands' last), then (from version 2) the preset
+// slots (PresetSlots::writeState()). All little-endian.
+static constexpr int stateMagic = 0x51455342;   // "BSEQ"
+static constexpr int stateVersion = 2;
+static constexpr int stateHeaderSize = 3 * (int) sizeof(int);
+
 void SimpleEQAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
     // You should use this method to store your parameters in the memory block.
@@ -230,8 +272,15 @@ void SimpleEQAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
     
     // second parameter: append to existing content or not:
     juce::MemoryOutputStream mos(destData, true);
-    // (current) state is an attribute of the apvts object:
-    apvts.state.writeToStream(mos);
+    
+    mos.writeInt(stateMagic);
+    mos.writeInt(stateVersion);
+    mos.writeInt(Parameters::NumParameters);
+    
+    for (int index = 0; index < Parameters::NumParameters; ++index)
+        mos.writeFloat(parameterHandles.get(static_cast<Parameters::Index>(index)));
+    
+    presetSlots.writeState(mos);
 }
 
 void SimpleEQAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
@@ -239,37 +288,97 @@ void SimpleEQAudioProcessor::setStateInformation (const void* data, int sizeInBy
     // You should use this method to restore your parameters from this memory block,
     // whose contents will have been created by the getStateInformation() call.
     
-    auto tree = juce::ValueTree::readFromData(data, sizeInBytes);
+    const auto startTicks = juce::Time::getHighResolutionTicks();
     
-    // if ValueTree is valid, replace/restore state and update filters:
-    if ( tree.isValid() ){
-        apvts.replaceState(tree);
-        updateFilters();
+    if (! restoreBinaryState(data, sizeInBytes))
+    {
+        // Sessions saved before the binary format hold the whole apvts ValueTree:
+        auto tree = juce::ValueTree::readFromData(data, sizeInBytes);
+        
+        // if ValueTree is valid (and ours, not some other plugin's data), replace/restore state:
+        if ( tree.isValid() && tree.hasType(apvts.state.getType()) )
+        {
+            apvts.replaceState(tree);
+            
+            // (those sessions had no preset slots)
+            presetSlots.clear();
+        }
     }
     
+    // (the restored parameter values flag the filters for redesigning on the audio thread)
+    
+    lastStateRecallTimeMs = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks) * 1000.0;
 }
 
+bool SimpleEQAudioProcessor::restoreBinaryState(const void* data, int sizeInBytes)
+{
+    if (data == nullptr || sizeInBytes < stateHeaderSize)
+        return false;
+    
+    juce::MemoryInputStream mis(data, (size_t) sizeInBytes, false);
+    
+    if (mis.readInt() != stateMagic)
+        return false;
+    
+    const auto version = mis.readInt();
+    const auto numStoredParameters = mis.readInt();
+    
+    // Version 1 chunks end with the parameters; later ones go on with the preset slots:
+    const auto numParameterBytes = sizeInBytes - stateHeaderSize - (version >= 2 ? PresetSlots::stateSizeInBytes : 0);
+    
+    // (the count is checked against the bytes left before multiplying, so a corrupt one can't overflow)
+    if (version < 1 || version > stateVersion || numStoredParameters < 0 || numParameterBytes < 0
+        || numStoredParameters != numParameterBytes / (int) sizeof(float)
+        || numParameterBytes % (int) sizeof(float) != 0)
+    {
+        // Recognisably ours, but corrupt (or from a newer build): leave the current state alone.
+        return true;
+    }
+    
+    // Parameters are only ever appended (chunks from before the extra bands hold just the fixed ones), so anything
+    // missing from an older chunk gets its default:
+    for (int index = 0; index < Parameters::NumParameters; ++index)
+    {
+        const auto spec = Parameters::getSpec(index);
+        const auto value = spec.index < numStoredParameters ? mis.readFloat() : spec.defaultValue;
+        auto& parameter = parameterHandles.getParameter(spec.index);
+        
+        // Updates the raw value straight away; apvts syncs its ValueTree lazily, on its own timer:
+        parameter.setValueNotifyingHost(parameter.convertTo0to1(value));
+    }
+    
+    // (and any this build doesn't know are skipped, to get to the preset slots)
+    if (numStoredParameters > Parameters::NumParameters)
+        mis.skipNextBytes((juce::int64) (numStoredParameters - Parameters::NumParameters) * (juce::int64) sizeof(float));
+    
+    if (version >= 2)
+        presetSlots.readState(mis);
+    else
+        presetSlots.clear();
+    
+    return true;
+}
 
 // get parameter settings:
-ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts)
+ChainSettings getChainSettings(const Parameters::Handles& parameters)
 
 {
     ChainSettings settings;
     
     // gets non-normalised values for each parameter:
-    settings.lowCutFreq = apvts.getRawParameterValue("LowCut Freq") -> load();
-    settings.highCutFreq = apvts.getRawParameterValue("HighCut Freq") -> load();
-    settings.peakFreq = apvts.getRawParameterValue("Peak Freq") -> load();
-    settings.peakQuality = apvts.getRawParameterValue("Peak Quality") -> load();
-    settings.peakGainInDecibels = apvts.getRawParameterValue("Peak Gain") -> load();
-    settings.lowCutSlope = static_cast<Slope>(apvts.getRawParameterValue("LowCut Slope") -> load());
-    settings.highCutSlope = static_cast<Slope>(apvts.getRawParameterValue("HighCut Slope") -> load());
+    settings.lowCutFreq = parameters.get(Parameters::LowCutFreq);
+    settings.highCutFreq = parameters.get(Parameters::HighCutFreq);
+    settings.peakFreq = parameters.get(Parameters::PeakFreq);
+    settings.peakQuality = parameters.get(Parameters::PeakQuality);
+    settings.peakGainInDecibels = parameters.get(Parameters::PeakGain);
+    settings.lowCutSlope = parameters.getChoice<Slope>(Parameters::LowCutSlope);
+    settings.highCutSlope = parameters.getChoice<Slope>(Parameters::HighCutSlope);
     
     // Bypass bool params stored as floats:
     
-    settings.lowCutBypassed = apvts.getRawParameterValue("LowCut Bypassed")-> load() > 0.5f;
-    settings.highCutBypassed = apvts.getRawParameterValue("HighCut Bypassed")-> load() > 0.5f;
-    settings.peakBypassed = apvts.getRawParameterValue("Peak Bypassed")-> load() > 0.5f;
+    settings.lowCutBypassed = parameters.getBool(Parameters::LowCutBypassed);
+    settings.highCutBypassed = parameters.getBool(Parameters::HighCutBypassed);
+    settings.peakBypassed = parameters.getBool(Parameters::PeakBypassed);
 
     return settings;
 }
@@ -280,125 +389,531 @@ Coefficients makePeakFilter(const ChainSettings &chainSettings, double sampleRat
     
 }
 
-void SimpleEQAudioProcessor::updatePeakFilter(const ChainSettings &chainSettings)
+void updateCoefficients(Coefficients &old, const Coefficients &replacements)
+{
+    *old = *replacements;
+}
+
+void updateCoefficients(Coefficients& old, const ChainCoefficients::Section& replacements)
 {
-//    auto peakCoefficients = juce::dsp::IIR::Coefficients<float>::makePeakFilter(getSampleRate(),                                                                                      chainSettings.peakFreq,                                                                            chainSettings.peakQuality,                                                                                                                                     juce::Decibels::decibelsToGain(chainSettings.peakGainInDecibels));
+    auto& destination = old->coefficients;
     
-    auto peakCoefficients = makePeakFilter(chainSettings, getSampleRate());
-   
-//    *leftChain.get<ChainPositions::Peak>().coefficients = *PeakCoefficients;
-//    *rightChain.get<ChainPositions::Peak>().coefficients = *PeakCoefficients;
+    // Sized in prepareToPlay(): a plain copy, never a reallocation:
+    jassert(destination.size() == ChainCoefficients::numCoefficients);
+    std::copy(replacements.begin(), replacements.end(), destination.begin());
+}
+
+void SimpleEQAudioProcessor::updateFilters()
+{
+    auto chainSettings = getChainSettings(parameterHandles);
     
-    leftChain.setBypassed<ChainPositions::Peak>(chainSettings.peakBypassed);
-    rightChain.setBypassed<ChainPositions::Peak>(chainSettings.peakBypassed);
+    // (only the topology in use is kept up to date; the other catches up when switched to)
+    if (usingSvfTopology)
+    {
+        applyChainSettings(svfChain, chainSettings);
+        bypassChainBands(bandEngine);
+        return;
+    }
     
-    updateCoefficients(leftChain.get<ChainPositions::Peak>().coefficients, peakCoefficients);
-    updateCoefficients(rightChain.get<ChainPositions::Peak>().coefficients, peakCoefficients);
+    // Only the bands that changed are redesigned, in place, so this never allocates:
+    applyChainSettings(bandEngine, chainSettings);
 }
 
-void updateCoefficients(Coefficients &old, const Coefficients &replacements)
+void SimpleEQAudioProcessor::updateExtraBands()
 {
-    *old = *replacements;
+    for (int i = 0; i < Parameters::numExtraBands; ++i)
+        bandEngine.setBand(ChainPositions::HighCut + 1 + i, getBandSettings(parameterHandles, i));
 }
 
-void SimpleEQAudioProcessor::updateLowCutFilters(const ChainSettings& chainSettings)
+bool SimpleEQAudioProcessor::updateFiltersIfNeeded()
 {
-    auto lowCutCoefficients = makeLowCutFilter(chainSettings, getSampleRate());
+    // On switching topology, the filters switched to start from silence, at the current settings:
+    const bool topologyChanged = parameterHandles.getBool(Parameters::SvfTopology) != usingSvfTopology;
+    
+    if (topologyChanged)
+    {
+        usingSvfTopology = ! usingSvfTopology;
+        
+        // (the biquads' fixed bands come back on from silence, as setBand() resets a band switched on)
+        if (usingSvfTopology)
+        {
+            svfChain.reset();
+            bypassChainBands(bandEngine);
+        }
+    }
+    
+    const bool parametersDidChange = parametersChanged.compareAndSetBool(false, true);
     
-    auto& leftLowCut = leftChain.get<ChainPositions::LowCut>();
-    auto& rightLowCut = rightChain.get<ChainPositions::LowCut>();
+    // The extra bands always follow the parameters (a preset slot only holds the fixed three):
+    if (parametersDidChange)
+        updateExtraBands();
     
-    leftChain.setBypassed<ChainPositions::LowCut>(chainSettings.lowCutBypassed);
-    rightChain.setBypassed<ChainPositions::LowCut>(chainSettings.lowCutBypassed); 
+    // A selected preset slot overrides the parameters (its coefficients are already designed):
+    if (usingSvfTopology ? presetSlots.applyTo(svfChain) : presetSlots.applyTo(bandEngine))
+    {
+        if (topologyChanged)
+            svfChain.finishGlides();
+        
+        followingPresetSlot = true;
+        return parametersDidChange;
+    }
+    
+    const bool slotWasDeselected = followingPresetSlot;
+    followingPresetSlot = false;
+    
+    if (parametersDidChange || slotWasDeselected || topologyChanged)
+    {
+        updateFilters();
+        
+        if (topologyChanged)
+            svfChain.finishGlides();
+        
+        return true;
+    }
     
-    updateCutFilter(leftLowCut, lowCutCoefficients, chainSettings.lowCutSlope);
-    updateCutFilter(rightLowCut, lowCutCoefficients, chainSettings.lowCutSlope);
+    return false;
+}
+
+void SimpleEQAudioProcessor::parameterValueChanged(int parameterIndex, float newValue)
+{
+    // (getParameters() is in Parameters::Index order; the analyser switch doesn't affect the filters, and
+    // a topology switch is picked up at the next boundary regardless)
+    if (parameterIndex != Parameters::AnalyserEnabled && parameterIndex != Parameters::SvfTopology)
+        parametersChanged.set(true);
 }
 
+//==============================================================================
+ChainCoefficients makeChainCoefficients(const ChainSettings& chainSettings, double sampleRate)
+{
+    ChainCoefficients result;
+    result.lowCut.fill(SectionDesign::unity);
+    result.highCut.fill(SectionDesign::unity);
+    result.peak = SectionDesign::unity;
+    
+    if (! chainSettings.peakBypassed)
+        SectionDesign::designPeak(chainSettings.peakFreq,
+                                  chainSettings.peakQuality,
+                                  juce::Decibels::decibelsToGain(chainSettings.peakGainInDecibels),
+                                  sampleRate,
+                                  result.peak);
+    
+    // (slope + 1) sections each, the rest stay at unity:
+    if (! chainSettings.lowCutBypassed)
+        SectionDesign::designButterworth(true, chainSettings.lowCutFreq, (chainSettings.lowCutSlope + 1) * 2, sampleRate, result.lowCut.data());
+    
+    if (! chainSettings.highCutBypassed)
+        SectionDesign::designButterworth(false, chainSettings.highCutFreq, (chainSettings.highCutSlope + 1) * 2, sampleRate, result.highCut.data());
+    
+    return result;
+}
 
-void SimpleEQAudioProcessor::updateHighCutFilters(const ChainSettings& chainSettings)
+void interpolateChainCoefficients(const ChainCoefficients& a, const ChainCoefficients& b, float amount, ChainCoefficients& result)
 {
-    auto highCutCoefficients = makeLowCutFilter(chainSettings, getSampleRate());
+    auto interpolateSection = [amount](const ChainCoefficients::Section& from,
+                                       const ChainCoefficients::Section& to,
+                                       ChainCoefficients::Section& blended)
+    {
+        for (size_t i = 0; i < blended.size(); ++i)
+            blended[i] = from[i] + amount * (to[i] - from[i]);
+    };
+    
+    for (size_t i = 0; i < ChainCoefficients::numCutSections; ++i)
+    {
+        interpolateSection(a.lowCut[i], b.lowCut[i], result.lowCut[i]);
+        interpolateSection(a.highCut[i], b.highCut[i], result.highCut[i]);
+    }
     
-    auto& leftHighCut = leftChain.get<ChainPositions::HighCut>();
-    auto& rightHighCut = rightChain.get<ChainPositions::HighCut>();
+    interpolateSection(a.peak, b.peak, result.peak);
+}
+
+ChainSettings interpolateChainSettings(const ChainSettings& a, const ChainSettings& b, float amount)
+{
+    auto logInterpolate = [amount](float from, float to) { return from * std::pow(to / from, amount); };
     
-    leftChain.setBypassed<ChainPositions::HighCut>(chainSettings.highCutBypassed);
-    rightChain.setBypassed<ChainPositions::HighCut>(chainSettings.highCutBypassed);
+    auto result = amount < 0.5f ? a : b;
     
-    updateCutFilter(leftHighCut, highCutCoefficients, chainSettings.highCutSlope);
+    result.lowCutFreq = logInterpolate(a.lowCutFreq, b.lowCutFreq);
+    result.highCutFreq = logInterpolate(a.highCutFreq, b.highCutFreq);
+    result.peakFreq = logInterpolate(a.peakFreq, b.peakFreq);
+    result.peakQuality = logInterpolate(a.peakQuality, b.peakQuality);
+    result.peakGainInDecibels = a.peakGainInDecibels + amount * (b.peakGainInDecibels - a.peakGainInDecibels);
     
-    updateCutFilter(rightHighCut, highCutCoefficients, chainSettings.highCutSlope);
+    return result;
 }
 
+void applyChainSettings(SvfChain& svfChain, const ChainSettings& chainSettings)
+{
+    svfChain.setLowCut(chainSettings.lowCutFreq, (chainSettings.lowCutSlope + 1) * 2, chainSettings.lowCutBypassed);
+    svfChain.setPeak(chainSettings.peakFreq, chainSettings.peakGainInDecibels, chainSettings.peakQuality, chainSettings.peakBypassed);
+    svfChain.setHighCut(chainSettings.highCutFreq, (chainSettings.highCutSlope + 1) * 2, chainSettings.highCutBypassed);
+}
 
-void SimpleEQAudioProcessor::updateFilters()
+void applyChainSettings(BandEngine& bandEngine, const ChainSettings& chainSettings)
 {
-    auto chainSettings = getChainSettings(apvts);
-    updatePeakFilter(chainSettings);
-    updateLowCutFilters(chainSettings);
-    updateHighCutFilters(chainSettings);
+    BandSettings lowCut, peak, highCut;
+    
+    lowCut.type = BandType::LowCut;
+    lowCut.frequency = chainSettings.lowCutFreq;
+    lowCut.cutOrder = (chainSettings.lowCutSlope + 1) * 2;
+    lowCut.enabled = ! chainSettings.lowCutBypassed;
+    
+    peak.type = BandType::Bell;
+    peak.frequency = chainSettings.peakFreq;
+    peak.gainInDecibels = chainSettings.peakGainInDecibels;
+    peak.quality = chainSettings.peakQuality;
+    peak.enabled = ! chainSettings.peakBypassed;
+    
+    highCut.type = BandType::HighCut;
+    highCut.frequency = chainSettings.highCutFreq;
+    highCut.cutOrder = (chainSettings.highCutSlope + 1) * 2;
+    highCut.enabled = ! chainSettings.highCutBypassed;
+    
+    bandEngine.setBand(ChainPositions::LowCut, lowCut);
+    bandEngine.setBand(ChainPositions::Peak, peak);
+    bandEngine.setBand(ChainPositions::HighCut, highCut);
 }
 
+void applyChainCoefficients(BandEngine& bandEngine, const ChainCoefficients& chainCoefficients)
+{
+    bandEngine.setBandSections(ChainPositions::LowCut, chainCoefficients.lowCut.data(), ChainCoefficients::numCutSections);
+    bandEngine.setBandSections(ChainPositions::Peak, &chainCoefficients.peak, 1);
+    bandEngine.setBandSections(ChainPositions::HighCut, chainCoefficients.highCut.data(), ChainCoefficients::numCutSections);
+}
 
+void bypassChainBands(BandEngine& bandEngine)
+{
+    bandEngine.setBand(ChainPositions::LowCut, {});
+    bandEngine.setBand(ChainPositions::Peak, {});
+    bandEngine.setBand(ChainPositions::HighCut, {});
+}
 
+BandSettings getBandSettings(const Parameters::Handles& parameters, int extraBand)
+{
+    auto field = [extraBand](Parameters::BandField bandField) { return Parameters::getBandParameter(extraBand, bandField); };
+    
+    BandSettings settings;
+    
+    settings.type = parameters.getChoice<BandType>(field(Parameters::BandFilterType));
+    settings.frequency = parameters.get(field(Parameters::BandFreq));
+    settings.gainInDecibels = parameters.get(field(Parameters::BandGain));
+    settings.quality = parameters.get(field(Parameters::BandQuality));
+    settings.cutOrder = (parameters.getChoice<Slope>(field(Parameters::BandSlope)) + 1) * 2;
+    settings.enabled = ! parameters.getBool(field(Parameters::BandBypassed));
+    
+    return settings;
+}
 
+//==============================================================================
+const ChainCoefficients& DesignCache::get(const ChainSettings& chainSettings, double sampleRate)
+{
+    ++useCount;
+    
+    auto* leastRecentlyUsed = &entries[0];
+    
+    for (auto& entry : entries)
+    {
+        if (entry.sampleRate == sampleRate && entry.settings == chainSettings)
+        {
+            entry.lastUsed = useCount;
+            return entry.coefficients;
+        }
+        
+        if (entry.lastUsed < leastRecentlyUsed->lastUsed)
+            leastRecentlyUsed = &entry;
+    }
+    
+    *leastRecentlyUsed = { chainSettings, sampleRate, makeChainCoefficients(chainSettings, sampleRate), useCount };
+    return leastRecentlyUsed->coefficients;
+}
 
-juce::AudioProcessorValueTreeState::ParameterLayout
-SimpleEQAudioProcessor::createParameterLayout()
+//==============================================================================
+void PresetSlots::prepare(double sampleRate, DesignCache& designCache)
+{
+    std::array<ChainSettings, numSlots> settings;
+    std::array<bool, numSlots> stored;
+    std::array<int, numSlots> revisions;
+    
+    {
+        const juce::SpinLock::ScopedLockType sl(lock);
+        
+        settings = slotSettings;
+        stored = isStored;
+        revisions = slotRevisions;
+    }
+    
+    // Redesign outside the lock, so the audio thread is never kept waiting on it:
+    std::array<ChainCoefficients, numSlots> designs;
+    for (size_t i = 0; i < numSlots; ++i)
+        if (stored[i])
+            designs[i] = designCache.get(settings[i], sampleRate);
+    
+    const juce::SpinLock::ScopedLockType sl(lock);
+    
+    designSampleRate = sampleRate;
+    
+    // (skipping any slot stored meanwhile, which is already designed for the new rate)
+    for (size_t i = 0; i < numSlots; ++i)
+        if (stored[i] && slotRevisions[i] == revisions[i])
+            slotCoefficients[i] = designs[i];
+    
+    // The chains have just been reset too, so whatever's selected needs applying again:
+    ++revision;
+}
+
+void PresetSlots::store(int slot, const ChainSettings& chainSettings)
+{
+    jassert(juce::isPositiveAndBelow(slot, numSlots));
+    
+    for (;;)
+    {
+        double sampleRate;
+        {
+            const juce::SpinLock::ScopedLockType sl(lock);
+            sampleRate = designSampleRate;
+        }
+        
+        // Before the first prepare() there's no sample rate to design for; prepare() designs the slot then:
+        auto design = sampleRate > 0.0 ? makeChainCoefficients(chainSettings, sampleRate) : ChainCoefficients();
+        
+        const juce::SpinLock::ScopedLockType sl(lock);
+        
+        // prepare() changed the rate while this was designing: go again for the new one.
+        if (sampleRate != designSampleRate)
+            continue;
+        
+        slotSettings[(size_t) slot] = chainSettings;
+        slotCoefficients[(size_t) slot] = design;
+        isStored[(size_t) slot] = true;
+        ++slotRevisions[(size_t) slot];
+        ++revision;
+        ++changeCount;
+        return;
+    }
+}
+
+void PresetSlots::clear()
 {
-    juce::AudioProcessorValueTreeState::ParameterLayout layout;
+    selectedSlot.set(noSlot);
+    morphTargetSlot.set(noSlot);
+    morphAmount.set(0.f);
+    
+    const juce::SpinLock::ScopedLockType sl(lock);
     
-    // params: name, range, interval, skew, default value
-    layout.add(std::make_unique<juce::AudioParameterFloat>("LowCut Freq",
-                                                           "LowCut Freq", juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 0.35f), 20.f));
+    for (size_t i = 0; i < numSlots; ++i)
+    {
+        isStored[i] = false;
+        ++slotRevisions[i];
+    }
     
-    layout.add(std::make_unique<juce::AudioParameterFloat>("HighCut Freq",
-                                                           "HighCut Freq", juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 1.f), 20000.f));
+    ++revision;
+    ++changeCount;
+}
+
+bool PresetSlots::isSlotStored(int slot) const
+{
+    if (! juce::isPositiveAndBelow(slot, numSlots))
+        return false;
     
-    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak Freq",
-                                                           "Peak Freq", juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 0.35f), 750.f));
+    const juce::SpinLock::ScopedLockType sl(lock);
+    return isStored[(size_t) slot];
+}
+
+bool PresetSlots::getActiveSettings(ActiveSettings& activeSettings) const
+{
+    const auto slot = selectedSlot.get();
+    const auto targetSlot = morphTargetSlot.get();
+    const auto amount = morphAmount.get();
     
-    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak Gain",
-                                                           "Peak Gain", juce::NormalisableRange<float>(-24.f, 24.f, 1.f, 1.f), 0.0f));
+    const juce::SpinLock::ScopedLockType sl(lock);
     
-    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak Quality",
-                                                           "Peak Quality", juce::NormalisableRange<float>(0.1f, 10.f, 0.05f, 1.f), 1.f));
+    // (the same tests the audio thread makes in applyTo())
+    if (! juce::isPositiveAndBelow(slot, numSlots) || ! isStored[(size_t) slot])
+        return false;
     
-    layout.add(std::make_unique<juce::AudioParameterBool>("LowCut Bypassed",
-                                                          "LowCut Bypassed",
-                                                          false));
+    activeSettings.slot = slotSettings[(size_t) slot];
+    activeSettings.isMorphing = juce::isPositiveAndBelow(targetSlot, numSlots) && isStored[(size_t) targetSlot] && amount > 0.f;
+    activeSettings.target = activeSettings.isMorphing ? slotSettings[(size_t) targetSlot] : activeSettings.slot;
+    activeSettings.amount = activeSettings.isMorphing ? amount : 0.f;
     
-    layout.add(std::make_unique<juce::AudioParameterBool>("HighCut Bypassed",
-                                                          "HighCut Bypassed",
-                                                          false));
+    return true;
+}
+
+void PresetSlots::writeState(juce::OutputStream& output) const
+{
+    std::array<ChainSettings, numSlots> settings;
+    std::array<bool, numSlots> stored;
     
-    layout.add(std::make_unique<juce::AudioParameterBool>("Peak Bypassed",
-                                                          "Peak Bypassed",
-                                                          false));
+    {
+        const juce::SpinLock::ScopedLockType sl(lock);
+        
+        settings = slotSettings;
+        stored = isStored;
+    }
     
-    layout.add(std::make_unique<juce::AudioParameterBool>("Analyser Enabled",
-                                                          "Analyser Enabled",
-                                                          true));
+    for (size_t i = 0; i < numSlots; ++i)
+    {
+        const auto& s = settings[i];
+        
+        output.writeInt(stored[i] ? 1 : 0);
+        output.writeFloat(s.lowCutFreq);
+        output.writeFloat(s.highCutFreq);
+        output.writeFloat(s.peakFreq);
+        output.writeFloat(s.peakGainInDecibels);
+        output.writeFloat(s.peakQuality);
+        output.writeInt(s.lowCutSlope);
+        output.writeInt(s.highCutSlope);
+        output.writeInt(s.lowCutBypassed ? 1 : 0);
+        output.writeInt(s.highCutBypassed ? 1 : 0);
+        output.writeInt(s.peakBypassed ? 1 : 0);
+    }
     
+    output.writeInt(selectedSlot.get());
+    output.writeInt(morphTargetSlot.get());
+    output.writeFloat(morphAmount.get());
+}
+
+void PresetSlots::readState(juce::InputStream& input)
+{
+    // Anything out of the parameter's range (or not a number) in a corrupt chunk falls back to its default:
+    auto readValue = [&input](Parameters::Index index)
+    {
+        const auto& spec = Parameters::specs[index];
+        const auto value = input.readFloat();
+        
+        return std::isfinite(value) && value >= spec.minimum && value <= spec.maximum ? value : spec.defaultValue;
+    };
     
+    auto readSlope = [&input]
+    {
+        return static_cast<Slope>(juce::jlimit((int) Slope::Slope_12, (int) Slope::Slope_48, input.readInt()));
+    };
     
+    clear();
     
-    juce::StringArray stringArray;
-    for (int i = 0; i < 4; ++i)
+    for (int i = 0; i < numSlots; ++i)
     {
-        juce::String str;
-        str << (12 + i * 12);
-        str << " db/Oct";
-        stringArray.add(str);
+        const bool stored = input.readInt() != 0;
+        
+        ChainSettings s;
+        s.lowCutFreq = readValue(Parameters::LowCutFreq);
+        s.highCutFreq = readValue(Parameters::HighCutFreq);
+        s.peakFreq = readValue(Parameters::PeakFreq);
+        s.peakGainInDecibels = readValue(Parameters::PeakGain);
+        s.peakQuality = readValue(Parameters::PeakQuality);
+        s.lowCutSlope = readSlope();
+        s.highCutSlope = readSlope();
+        s.lowCutBypassed = input.readInt() != 0;
+        s.highCutBypassed = input.readInt() != 0;
+        s.peakBypassed = input.readInt() != 0;
+        
+        if (stored)
+            store(i, s);
     }
     
-    // Depth of high cut/low cut filters
-    layout.add(std::make_unique<juce::AudioParameterChoice>("LowCut Slope", "LowCut Slope", stringArray, 0));
+    const auto slot = input.readInt();
+    const auto targetSlot = input.readInt();
+    const auto amount = input.readFloat();
     
-    layout.add(std::make_unique<juce::AudioParameterChoice>("HighCut Slope", "HighCut Slope", stringArray, 0));
+    select(juce::isPositiveAndBelow(slot, numSlots) ? slot : noSlot);
+    setMorph(juce::isPositiveAndBelow(targetSlot, numSlots) ? targetSlot : noSlot, std::isfinite(amount) ? amount : 0.f);
+}
+
+bool PresetSlots::applyTo(BandEngine& bandEngine)
+{
+    AppliedState requested;
+    requested.slot = selectedSlot.get();
     
-    return layout;
+    if (requested.slot == noSlot)
+    {
+        appliedState = {};
+        return false;
+    }
+    
+    const juce::SpinLock::ScopedTryLockType tryLock(lock);
+    
+    // A slot is being stored right now: keep whatever's in the bands for one more block:
+    if (! tryLock.isLocked())
+        return appliedState.slot != noSlot;
+    
+    if (! isStored[(size_t) requested.slot] || designSampleRate <= 0.0)
+    {
+        appliedState = {};
+        return false;
+    }
+    
+    requested.revision = revision;
+    
+    const auto targetSlot = morphTargetSlot.get();
+    const auto amount = morphAmount.get();
+    
+    if (juce::isPositiveAndBelow(targetSlot, numSlots) && isStored[(size_t) targetSlot] && amount > 0.f)
+    {
+        requested.targetSlot = targetSlot;
+        requested.amount = amount;
+    }
+    
+    if (requested == appliedState)
+        return true;
+    
+    const ChainCoefficients* chainCoefficients = &slotCoefficients[(size_t) requested.slot];
+    
+    if (requested.targetSlot != noSlot)
+    {
+        interpolateChainCoefficients(*chainCoefficients, slotCoefficients[(size_t) requested.targetSlot], requested.amount, blendedCoefficients);
+        chainCoefficients = &blendedCoefficients;
+    }
+    
+    applyChainCoefficients(bandEngine, *chainCoefficients);
+    
+    appliedState = requested;
+    return true;
+}
+
+bool PresetSlots::applyTo(SvfChain& svfChain)
+{
+    const auto slot = selectedSlot.get();
+    
+    // (the engine's fixed bands are off meanwhile, so coming back to it applies the slot again)
+    appliedState = {};
+    
+    if (slot == noSlot)
+    {
+        svfFollowingSlot = false;
+        return false;
+    }
+    
+    const juce::SpinLock::ScopedTryLockType tryLock(lock);
+    
+    // A slot is being stored right now: keep gliding to the settings already set for one more block:
+    if (! tryLock.isLocked())
+        return svfFollowingSlot;
+    
+    svfFollowingSlot = isStored[(size_t) slot];
+    
+    if (! svfFollowingSlot)
+        return false;
+    
+    // (setting the same targets again is a no-op, so there's nothing to gain from skipping this)
+    const auto targetSlot = morphTargetSlot.get();
+    const auto amount = morphAmount.get();
+    
+    if (juce::isPositiveAndBelow(targetSlot, numSlots) && isStored[(size_t) targetSlot] && amount > 0.f)
+        applyChainSettings(svfChain, interpolateChainSettings(slotSettings[(size_t) slot], slotSettings[(size_t) targetSlot], amount));
+    else
+        applyChainSettings(svfChain, slotSettings[(size_t) slot]);
+    
+    return true;
+}
+
+
+
+
+
+juce::AudioProcessorValueTreeState::ParameterLayout
+SimpleEQAudioProcessor::createParameterLayout()
+{
+    // IDs, ranges and defaults are all listed in Parameters::specs:
+    return Parameters::createParameterLayout();
 }
 
 //==============================================================================
@@ -10,6 +10,13 @@
 
 #include <JuceHeader.h>
 
+#include "Parameters.h"
+#include "LoadMeter.h"
+#include "AnalyzerLatency.h"
+#include "SectionDesign.h"
+#include "SvfChain.h"
+#include "BandEngine.h"
+
 #include <array>
 
 template<typename T>
@@ -45,6 +52,10 @@ struct Fifo
     
     bool push(const T& t)
     {
+        // Same-sized buffers copy without reallocating, which matters when pushing from the audio thread:
+        if constexpr (std::is_same_v<T, juce::AudioBuffer<float>>)
+            jassert(t.getNumChannels() == buffers[0].getNumChannels() && t.getNumSamples() == buffers[0].getNumSamples());
+        
         auto write = fifo.write(1);
         if( write.blockSize1 > 0 )
         {
@@ -71,6 +82,17 @@ struct Fifo
     {
         return fifo.getNumReady();
     }
+    
+    int getNumAvailableForWriting() const
+    {
+        return fifo.getFreeSpace();
+    }
+    
+    // Drops anything not yet pulled. Neither side may be using the fifo meanwhile:
+    void reset()
+    {
+        fifo.reset();
+    }
 private:
     static constexpr int Capacity = 30;
     std::array<T, Capacity> buffers;
@@ -103,8 +125,15 @@ struct SingleChannelSampleFifo
         }
     }
 
+    /*
+     The host only re-prepares while the audio thread is stopped, but the consumer (the analyser)
+     may still be running, so this holds consumerLock (which the audio thread never touches).
+     Buffers of the old size that haven't been pulled yet are dropped, along with their stamps.
+     */
     void prepare(int bufferSize)
     {
+        const juce::ScopedLock sl(consumerLock);
+        
         prepared.set(false);
         size.set(bufferSize);
         bufferToFill.setSize(1,             //channel
@@ -113,7 +142,10 @@ struct SingleChannelSampleFifo
                              true,          //clear extra space
                              true);         //avoid reallocating
         audioBufferFifo.prepare(1, bufferSize);
+        audioBufferFifo.reset();
+        stampFifo.reset();
         fifoIndex = 0;
+        samplesCaptured = 0;
         prepared.set(true);
     }
     //==============================================================================
@@ -121,28 +153,53 @@ struct SingleChannelSampleFifo
     bool isPrepared() const {return prepared.get();}
     int getSize() const {return size.get();}
     //==============================================================================
-    bool getAudioBuffer(BlockType& buf) { return audioBufferFifo.pull(buf); }
+    bool getAudioBuffer(BlockType& buf)
+    {
+        // (the stamp still has to be pulled, to keep the two fifos in lockstep)
+        FrameStamp stamp;
+        return getAudioBuffer(buf, stamp);
+    }
+    
+    // Also returns the stamp of the buffer's last sample (the stamps travel in lockstep with the buffers):
+    bool getAudioBuffer(BlockType& buf, FrameStamp& stamp)
+    {
+        const juce::ScopedLock sl(consumerLock);
+        
+        if (! audioBufferFifo.pull(buf))
+            return false;
+        
+        stampFifo.pull(stamp);
+        return true;
+    }
     private:
         Channel channelToUse;
         int fifoIndex = 0;
         Fifo<BlockType> audioBufferFifo;
+        Fifo<FrameStamp> stampFifo;
+        juce::int64 samplesCaptured = 0;
         BlockType bufferToFill;
         juce::Atomic<bool> prepared = false;
         juce::Atomic<int> size = 0;
+        juce::CriticalSection consumerLock;
             
         void pushNextSampleIntoFifo(float sample)
         {
             if (fifoIndex == bufferToFill.getNumSamples())
             {
-                auto ok = audioBufferFifo.push(bufferToFill);
-
-                juce::ignoreUnused(ok);
+                // The stamp goes first, so a consumer that gets the buffer always finds its stamp.
+                // (this is the only writer, so the free space checked can only grow before the pushes)
+                if (audioBufferFifo.getNumAvailableForWriting() > 0 && stampFifo.getNumAvailableForWriting() > 0)
+                {
+                    stampFifo.push({ samplesCaptured - 1, juce::Time::getHighResolutionTicks() });
+                    audioBufferFifo.push(bufferToFill);
+                }
                     
                 fifoIndex = 0;
             }
                 
             bufferToFill.setSample(0, fifoIndex, sample);
             ++fifoIndex;
+            ++samplesCaptured;
         }
     };
 
@@ -162,11 +219,19 @@ struct ChainSettings
     Slope lowCutSlope{Slope::Slope_12}, highCutSlope {Slope::Slope_12};
     
     bool lowCutBypassed{false}, highCutBypassed{false}, peakBypassed{false};
+    
+    bool operator==(const ChainSettings& other) const
+    {
+        return peakFreq == other.peakFreq && peakGainInDecibels == other.peakGainInDecibels && peakQuality == other.peakQuality
+            && lowCutFreq == other.lowCutFreq && highCutFreq == other.highCutFreq
+            && lowCutSlope == other.lowCutSlope && highCutSlope == other.highCutSlope
+            && lowCutBypassed == other.lowCutBypassed && highCutBypassed == other.highCutBypassed && peakBypassed == other.peakBypassed;
+    }
 };
 
 
 // helper function for extracting filter parameter values (returns data struct):
-ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts);
+ChainSettings getChainSettings(const Parameters::Handles& parameters);
 
 // Aliases:
 using Filter = juce::dsp::IIR::Filter<float>;
@@ -175,9 +240,10 @@ using Filter = juce::dsp::IIR::Filter<float>;
 
 using CutFilter = juce::dsp::ProcessorChain<Filter, Filter, Filter, Filter>;
 
-// Mono channel chain:
+// Mono channel chain (the processor's filters before BandEngine; still the reference it's checked against):
 using MonoChain = juce::dsp::ProcessorChain<CutFilter, Filter, CutFilter>;
 
+// Also the fixed bands' places in the processor's BandEngine:
 enum ChainPositions
 {
     LowCut,
@@ -185,9 +251,24 @@ enum ChainPositions
     HighCut
 };
 
+// Raw coefficients (b0, b1, b2, a1, a2, normalised by a0) for every section of the fixed bands, with bypassed
+// and unused sections set to unity. Plain data, so it can be copied and blended without allocating:
+struct ChainCoefficients
+{
+    static constexpr int numCutSections = 4;
+    static constexpr int numCoefficients = 5;
+    using Section = SectionDesign::Section;
+    
+    std::array<Section, numCutSections> lowCut, highCut;
+    Section peak;
+};
+
 using Coefficients = Filter::CoefficientsPtr;
 void updateCoefficients(Coefficients& old, const Coefficients& replacements);
 
+// Copies a raw section into second-order coefficients in place (no allocation, so fine on the audio thread):
+void updateCoefficients(Coefficients& old, const ChainCoefficients::Section& replacements);
+
 Coefficients makePeakFilter(const ChainSettings& chainSettings, double sampleRate);
 
 // Helper function:
@@ -251,10 +332,164 @@ inline auto makeHighCutFilter(const ChainSettings& chainSettings, double sampleR
     
 }
 
+// Designs all the sections with the same formulas as makePeakFilter()/makeLowCutFilter()/makeHighCutFilter(),
+// but straight into plain arrays, so it never allocates and is fine on the audio thread:
+ChainCoefficients makeChainCoefficients(const ChainSettings& chainSettings, double sampleRate);
+
+// Linear blend of two designs (amount 0 -> a, 1 -> b). Stable sections always blend into stable ones,
+// as the region of stable (a1, a2) pairs is a triangle, which is convex:
+void interpolateChainCoefficients(const ChainCoefficients& a, const ChainCoefficients& b, float amount, ChainCoefficients& result);
+
+// The same blend of the settings themselves, for SvfChain (frequencies and Q on a log scale, gain in dB;
+// slopes and bypasses switch half way):
+ChainSettings interpolateChainSettings(const ChainSettings& a, const ChainSettings& b, float amount);
+
+// Glides the SVF filters to the settings:
+void applyChainSettings(SvfChain& svfChain, const ChainSettings& chainSettings);
+
+// The fixed bands as BandEngine bands (at ChainPositions), each redesigned only if it changed:
+void applyChainSettings(BandEngine& bandEngine, const ChainSettings& chainSettings);
+
+// Runs the fixed bands with these sections instead of their settings' design:
+void applyChainCoefficients(BandEngine& bandEngine, const ChainCoefficients& chainCoefficients);
+
+// Takes the fixed bands out of the engine (while the SVFs run them):
+void bypassChainBands(BandEngine& bandEngine);
+
+// An extra band's parameters (0 for "Band 4"), as BandEngine settings:
+BandSettings getBandSettings(const Parameters::Handles& parameters, int extraBand);
+
+/**
+ The most recent designs, whatever their sample rate, so a host switching back and forth between rates (or an
+ offline render at another rate and back) gets the designs it had before instead of redesigning them.
+ 
+ Not thread-safe, and only for prepareToPlay(): the audio thread designs afresh, as automation would only
+ flush it.
+ */
+class DesignCache
+{
+public:
+    // (enough for every preset slot's design, at four rates)
+    static constexpr int capacity = 16;
+    
+    // Designs on a miss, replacing the least recently used entry:
+    const ChainCoefficients& get(const ChainSettings& chainSettings, double sampleRate);
+    
+private:
+    struct Entry
+    {
+        ChainSettings settings;
+        double sampleRate = 0.0;
+        ChainCoefficients coefficients;
+        juce::uint32 lastUsed = 0;
+    };
+    
+    std::array<Entry, capacity> entries;
+    juce::uint32 useCount = 0;
+};
+
+/**
+ In-memory A/B slots of EQ settings, each designed ahead of time on the thread that stores it.
+ 
+ While a slot is selected, the audio thread just copies its coefficients into the fixed bands in place of the
+ parameters, or blends them with a morph target slot: a fixed cost per block, with no filter design. The
+ extra bands aren't part of a slot, and keep following their parameters.
+ */
+class PresetSlots
+{
+public:
+    static constexpr int numSlots = 4;
+    static constexpr int noSlot = -1;
+    
+    // Not for the audio thread (designs come from the cache where it has them):
+    void prepare(double sampleRate, DesignCache& designCache);
+    void store(int slot, const ChainSettings& chainSettings);
+    
+    // Not for the audio thread either. Empties every slot, and goes back to following the parameters:
+    void clear();
+    
+    bool isSlotStored(int slot) const;
+    
+    // noSlot goes back to following the parameters:
+    void select(int slot) { selectedSlot.set(slot); ++changeCount; }
+    int getSelectedSlot() const { return selectedSlot.get(); }
+    
+    // amount 0 -> selected slot, 1 -> target slot:
+    void setMorph(int targetSlot, float amount)
+    {
+        morphTargetSlot.set(targetSlot);
+        morphAmount.set(juce::jlimit(0.f, 1.f, amount));
+        ++changeCount;
+    }
+    
+    int getMorphTargetSlot() const { return morphTargetSlot.get(); }
+    float getMorphAmount() const { return morphAmount.get(); }
+    
+    // Bumped by every store, clear, selection and morph change (for editors to poll):
+    int getChangeCount() const { return changeCount.get(); }
+    
+    // What the chains follow while a stored slot is selected: its settings, and the morph target's with the
+    // amount if morphing. Returns false while they follow the parameters (not for the audio thread):
+    struct ActiveSettings
+    {
+        ChainSettings slot, target;
+        float amount = 0.f;
+        bool isMorphing = false;
+    };
+    
+    bool getActiveSettings(ActiveSettings& activeSettings) const;
+    
+    // The slots, selection and morph in the plugin's state chunk, after the parameters. Each slot is a stored
+    // flag then its settings; then the selected slot, morph target and amount. All 4 bytes each:
+    static constexpr int stateSizeInBytes = numSlots * 11 * 4 + 3 * 4;
+    
+    void writeState(juce::OutputStream& output) const;
+    
+    // Reads exactly stateSizeInBytes, replacing every slot (not for the audio thread):
+    void readState(juce::InputStream& input);
+    
+    // Audio thread. Returns false when no (stored) slot is selected, and the fixed bands should follow the parameters:
+    bool applyTo(BandEngine& bandEngine);
+    
+    // Audio thread, for the SVF topology, which glides between settings rather than blending designs:
+    bool applyTo(SvfChain& svfChain);
+    
+private:
+    juce::Atomic<int> selectedSlot {noSlot}, morphTargetSlot {noSlot};
+    juce::Atomic<float> morphAmount {0.f};
+    juce::Atomic<int> changeCount {0};
+    
+    // Everything below is guarded by 'lock', which the audio thread only ever tries to take:
+    mutable juce::SpinLock lock;
+    double designSampleRate = 0.0;
+    std::array<ChainSettings, numSlots> slotSettings;
+    std::array<bool, numSlots> isStored {};
+    std::array<int, numSlots> slotRevisions {};
+    std::array<ChainCoefficients, numSlots> slotCoefficients;
+    int revision = 0;
+    
+    // Audio thread only: what's currently in the chains, to skip copying when nothing changed:
+    struct AppliedState
+    {
+        int slot = noSlot, targetSlot = noSlot, revision = -1;
+        float amount = 0.f;
+        
+        bool operator==(const AppliedState& other) const
+        {
+            return slot == other.slot && targetSlot == other.targetSlot && revision == other.revision && amount == other.amount;
+        }
+    };
+    
+    AppliedState appliedState;
+    ChainCoefficients blendedCoefficients;
+    bool svfFollowingSlot = false;
+};
+
 //==============================================================================
 /**
 */
-class SimpleEQAudioProcessor  : public juce::AudioProcessor
+class SimpleEQAudioProcessor  : public juce::AudioProcessor,
+                                juce::AudioProcessorParameter::Listener
                             #if JucePlugin_Enable_ARA
                              , public juce::AudioProcessorARAExtension
                             #endif
@@ -275,6 +510,11 @@ public:
    #endif
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    
+    // Flags the filters for redesigning at the next (sub-)block boundary; may be called on any thread:
+    void parameterValueChanged (int parameterIndex, float newValue) override;
+    
+    void parameterGestureChanged (int parameterIndex, bool gestureIsStarting) override {};
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -299,24 +539,75 @@ public:
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
     
+    // Time (ms) the last setStateInformation() call took:
+    double getLastStateRecallTimeMs() const { return lastStateRecallTimeMs; }
+    
+    // What the last prepareToPlay() call had to do, and the time (ms) it took:
+    enum class PrepareKind
+    {
+        Full,               // (the first call)
+        SampleRateChange,
+        BlockSizeChange,
+        Unchanged
+    };
+    
+    PrepareKind getLastPrepareKind() const { return lastPrepareKind; }
+    double getLastPrepareTimeMs() const { return lastPrepareTimeMs; }
+    
     static juce::AudioProcessorValueTreeState::ParameterLayout
         createParameterLayout();
     
     juce::AudioProcessorValueTreeState apvts {*this, nullptr, "Parameters", createParameterLayout()};
     
+    // Resolved once from apvts (so must be declared after it):
+    const Parameters::Handles parameterHandles {apvts};
+    
     using BlockType = juce::AudioBuffer<float>;
     SingleChannelSampleFifo<BlockType> leftChannelFifo{Channel::Left};
     SingleChannelSampleFifo<BlockType> rightChannelFifo{Channel::Right};
     
+    // A/B settings slots; a selected slot overrides the parameters on the audio thread:
+    PresetSlots presetSlots;
+    
+    // Per-instance timing, for the editor's overlay or for monitoring: processBlock against the block's
+    // duration, the analyser and the response curve's paint() against a display frame:
+    LoadMeter dspLoad, analyzerLoad, paintLoad;
+    
+    // How stale the analyser's frames are at each stage, from capture to paint:
+    AnalyzerLatency analyzerLatency;
+    
 private:
-    MonoChain leftChain, rightChain;
+    // Every band, both channels: the fixed three at ChainPositions, then the extra bands:
+    BandEngine bandEngine;
     
-    void updatePeakFilter(const ChainSettings &chainSettings);
-        
-    void updateLowCutFilters(const ChainSettings& chainSettings);
-    void updateHighCutFilters(const ChainSettings& chainSettings);
-
+    // The alternative topology for the fixed three bands, used instead of the engine's while the SvfTopology
+    // parameter is on (the engine still runs the extra bands after it):
+    SvfChain svfChain;
+    bool usingSvfTopology = false;
+    
+    // The fixed bands, in whichever topology is in use:
     void updateFilters();
+    void updateExtraBands();
+    
+    // Redesigns the filters only if a parameter changed since the last call (or a preset slot was just
+    // deselected); returns true if it did:
+    bool updateFiltersIfNeeded();
+    
+    juce::Atomic<bool> parametersChanged { true };
+    bool followingPresetSlot = false;
+    
+    // Returns false if the data isn't in the binary state format (i.e. is an older ValueTree chunk):
+    bool restoreBinaryState(const void* data, int sizeInBytes);
+    
+    double lastStateRecallTimeMs = 0.0;
+    
+    // The spec of the last prepareToPlay() call (0 before the first), to tell what the next one changes:
+    double preparedSampleRate = 0.0;
+    int preparedBlockSize = 0;
+    
+    DesignCache designCache;
+    PrepareKind lastPrepareKind = PrepareKind::Full;
+    double lastPrepareTimeMs = 0.0;
     
     // Osc to verify FFT spectrum analyser accuracy:
     
@@ -0,0 +1,84 @@
+/*
+  ==============================================================================
+
+    SectionDesign.cpp
+
+  ==============================================================================
+*/
+
+#include "SectionDesign.h"
+
+namespace SectionDesign
+{
+    void designPeak(float frequency, float quality, float gainFactor, double sampleRate, Section& section)
+    {
+        const auto A = juce::jmax(0.f, std::sqrt(gainFactor));
+        const auto omega = (2 * juce::MathConstants<float>::pi * juce::jmax(frequency, 2.f)) / static_cast<float>(sampleRate);
+        const auto alpha = std::sin(omega) / (quality * 2);
+        const auto c2 = -2 * std::cos(omega);
+        const auto alphaTimesA = alpha * A;
+        const auto alphaOverA = alpha / A;
+        const auto a0Inverse = 1 / (1 + alphaOverA);
+
+        section = { (1 + alphaTimesA) * a0Inverse, c2 * a0Inverse, (1 - alphaTimesA) * a0Inverse, c2 * a0Inverse, (1 - alphaOverA) * a0Inverse };
+    }
+
+    void designLowShelf(float frequency, float quality, float gainFactor, double sampleRate, Section& section)
+    {
+        const auto A = juce::jmax(0.f, std::sqrt(gainFactor));
+        const auto aMinus1 = A - 1;
+        const auto aPlus1 = A + 1;
+        const auto omega = (2 * juce::MathConstants<float>::pi * juce::jmax(frequency, 2.f)) / static_cast<float>(sampleRate);
+        const auto cosOmega = std::cos(omega);
+        const auto beta = std::sin(omega) * std::sqrt(A) / quality;
+        const auto aMinus1TimesCosOmega = aMinus1 * cosOmega;
+        const auto a0Inverse = 1 / (aPlus1 + aMinus1TimesCosOmega + beta);
+
+        section = { A * (aPlus1 - aMinus1TimesCosOmega + beta) * a0Inverse,
+                    A * 2 * (aMinus1 - aPlus1 * cosOmega) * a0Inverse,
+                    A * (aPlus1 - aMinus1TimesCosOmega - beta) * a0Inverse,
+                    -2 * (aMinus1 + aPlus1 * cosOmega) * a0Inverse,
+                    (aPlus1 + aMinus1TimesCosOmega - beta) * a0Inverse };
+    }
+
+    void designHighShelf(float frequency, float quality, float gainFactor, double sampleRate, Section& section)
+    {
+        const auto A = juce::jmax(0.f, std::sqrt(gainFactor));
+        const auto aMinus1 = A - 1;
+        const auto aPlus1 = A + 1;
+        const auto omega = (2 * juce::MathConstants<float>::pi * juce::jmax(frequency, 2.f)) / static_cast<float>(sampleRate);
+        const auto cosOmega = std::cos(omega);
+        const auto beta = std::sin(omega) * std::sqrt(A) / quality;
+        const auto aMinus1TimesCosOmega = aMinus1 * cosOmega;
+        const auto a0Inverse = 1 / (aPlus1 - aMinus1TimesCosOmega + beta);
+
+        section = { A * (aPlus1 + aMinus1TimesCosOmega + beta) * a0Inverse,
+                    A * -2 * (aMinus1 + aPlus1 * cosOmega) * a0Inverse,
+                    A * (aPlus1 + aMinus1TimesCosOmega - beta) * a0Inverse,
+                    2 * (aMinus1 - aPlus1 * cosOmega) * a0Inverse,
+                    (aPlus1 - aMinus1TimesCosOmega - beta) * a0Inverse };
+    }
+
+    // i.e. IIR::Coefficients::makeHighPass()/makeLowPass() with the Butterworth Qs:
+    void designButterworth(bool isHighPass, float frequency, int order, double sampleRate, Section* sections)
+    {
+        jassert(order >= 2 && order <= 8 && order % 2 == 0);
+
+        const auto tanOmega = std::tan(juce::MathConstants<float>::pi * frequency / static_cast<float>(sampleRate));
+        const auto n = isHighPass ? tanOmega : 1 / tanOmega;
+        const auto nSquared = n * n;
+
+        for (int i = 0; i < order / 2; ++i)
+        {
+            const auto Q = static_cast<float>(1.0 / (2.0 * std::cos((2.0 * i + 1.0) * juce::MathConstants<double>::pi / (order * 2.0))));
+            const auto invQ = 1 / Q;
+            const auto c1 = 1 / (1 + invQ * n + nSquared);
+
+            sections[i] = { c1,
+                            isHighPass ? c1 * -2 : c1 * 2,
+                            c1,
+                            isHighPass ? c1 * 2 * (nSquared - 1) : c1 * 2 * (1 - nSquared),
+                            c1 * (1 - invQ * n + nSquared) };
+        }
+    }
+}
@@ -0,0 +1,34 @@
+/*
+  ==============================================================================
+
+    SectionDesign.h
+
+    Allocation-free biquad section designers, shared by BandEngine and
+    makeChainCoefficients().
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <array>
+
+// Second order sections designed straight into plain arrays, with the same formulas (and float precision)
+// as juce::dsp::IIR::Coefficients / FilterDesign. Nothing here allocates, so it's all fine on the audio thread:
+namespace SectionDesign
+{
+    // b0, b1, b2, a1, a2, normalised by a0:
+    using Section = std::array<float, 5>;
+
+    inline constexpr Section unity { 1.f, 0.f, 0.f, 0.f, 0.f };
+
+    // As IIR::Coefficients::makePeakFilter(), makeLowShelf(), makeHighShelf():
+    void designPeak(float frequency, float quality, float gainFactor, double sampleRate, Section& section);
+    void designLowShelf(float frequency, float quality, float gainFactor, double sampleRate, Section& section);
+    void designHighShelf(float frequency, float quality, float gainFactor, double sampleRate, Section& section);
+
+    // As FilterDesign::design...HighOrderButterworthMethod() for an even order (2 to 8), into order / 2 sections:
+    void designButterworth(bool isHighPass, float frequency, int order, double sampleRate, Section* sections);
+}
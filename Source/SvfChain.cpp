@@ -0,0 +1,279 @@
+/*
+  ==============================================================================
+
+    SvfChain.cpp
+
+  ==============================================================================
+*/
+
+#include "SvfChain.h"
+
+// The trapezoidal SVF's per-sample update (A. Simper, "Linear Trapezoidal Integrated SVF"): v1 is the
+// band-pass output and v2 the low-pass, the high-pass being x - k * v1 - v2:
+static inline void tick(float x, float a1, float a2, float a3, float& ic1eq, float& ic2eq, float& v1, float& v2)
+{
+    const auto v3 = x - ic2eq;
+    v1 = a1 * ic1eq + a2 * v3;
+    v2 = ic2eq + a2 * ic1eq + a3 * v3;
+    ic1eq = 2 * v1 - ic1eq;
+    ic2eq = 2 * v2 - ic2eq;
+}
+
+static inline void tune(float g, float k, float& a1, float& a2, float& a3)
+{
+    a1 = 1 / (1 + g * (g + k));
+    a2 = g * a1;
+    a3 = g * a2;
+}
+
+//==============================================================================
+void SvfChain::prepare(double newSampleRate, int newNumChannels)
+{
+    jassert(newNumChannels <= maxChannels);
+
+    sampleRate = newSampleRate;
+    numChannels = juce::jmin(newNumChannels, maxChannels);
+
+    for (auto* smoothed : { &lowCut.frequency, &highCut.frequency, &peak.frequency, &peak.amplitude, &peak.quality })
+        smoothed->reset(sampleRate, glideSeconds);
+
+    lowCut.needsRetuning = highCut.needsRetuning = peak.needsRetuning = true;
+
+    reset();
+}
+
+void SvfChain::reset()
+{
+    for (auto* cut : { &lowCut, &highCut })
+        for (auto& channelState : cut->state)
+            channelState.fill({ 0.f, 0.f });
+
+    peak.state.fill({ 0.f, 0.f });
+}
+
+void SvfChain::setLowCut(float frequency, int order, bool bypassed)
+{
+    setCut(lowCut, frequency, order, bypassed);
+}
+
+void SvfChain::setHighCut(float frequency, int order, bool bypassed)
+{
+    setCut(highCut, frequency, order, bypassed);
+}
+
+void SvfChain::setCut(Cut& cut, float frequency, int order, bool bypassed)
+{
+    jassert(order >= 2 && order <= maxCutSections * 2 && order % 2 == 0);
+
+    const auto numSections = juce::jlimit(1, maxCutSections, order / 2);
+
+    // Sections coming (back) in start from silence, at the new frequency rather than gliding from an old one:
+    if (cut.bypassed && ! bypassed)
+    {
+        cut.frequency.setCurrentAndTargetValue(frequency);
+        cut.needsRetuning = true;
+
+        for (auto& channelState : cut.state)
+            channelState.fill({ 0.f, 0.f });
+    }
+    else
+    {
+        cut.frequency.setTargetValue(frequency);
+
+        for (auto& channelState : cut.state)
+            for (int section = cut.numSections; section < numSections; ++section)
+                channelState[(size_t) section] = { 0.f, 0.f };
+    }
+
+    if (numSections != cut.numSections)
+    {
+        // The Butterworth sections' Qs, as FilterDesign (and SectionDesign::designButterworth()) has them:
+        for (int i = 0; i < numSections; ++i)
+            cut.dampings[(size_t) i] = static_cast<float>(2.0 * std::cos((2.0 * i + 1.0) * juce::MathConstants<double>::pi / (numSections * 4.0)));
+
+        cut.numSections = numSections;
+        cut.needsRetuning = true;
+    }
+
+    if (cut.bypassed != bypassed)
+    {
+        cut.bypassed = bypassed;
+        cut.needsRetuning = true;
+    }
+}
+
+void SvfChain::setPeak(float frequency, float gainInDecibels, float quality, bool bypassed)
+{
+    const bool wasActive = peak.isActive();
+
+    // Bypassing glides to 0 dB, where the bell has no effect at all:
+    const auto amplitude = bypassed ? 1.f : juce::Decibels::decibelsToGain(gainInDecibels * 0.5f);
+
+    if (! wasActive && ! bypassed)
+    {
+        peak.frequency.setCurrentAndTargetValue(frequency);
+        peak.quality.setCurrentAndTargetValue(quality);
+        peak.needsRetuning = true;
+        peak.state.fill({ 0.f, 0.f });
+    }
+    else
+    {
+        peak.frequency.setTargetValue(frequency);
+        peak.quality.setTargetValue(quality);
+    }
+
+    // (anything else that changed is now gliding, and gets retuned as it goes)
+    peak.amplitude.setTargetValue(amplitude);
+    peak.bypassed = bypassed;
+}
+
+void SvfChain::finishGlides()
+{
+    for (auto* smoothed : { &lowCut.frequency, &highCut.frequency, &peak.frequency, &peak.amplitude, &peak.quality })
+        smoothed->setCurrentAndTargetValue(smoothed->getTargetValue());
+
+    lowCut.needsRetuning = highCut.needsRetuning = peak.needsRetuning = true;
+}
+
+bool SvfChain::isGliding() const
+{
+    return lowCut.frequency.isSmoothing() || highCut.frequency.isSmoothing()
+        || peak.frequency.isSmoothing() || peak.amplitude.isSmoothing() || peak.quality.isSmoothing();
+}
+
+float SvfChain::getG(float frequency) const
+{
+    // (kept below Nyquist, where the tan() blows up)
+    const auto normalised = juce::jmin(frequency / static_cast<float>(sampleRate), 0.499f);
+    return std::tan(juce::MathConstants<float>::pi * normalised);
+}
+
+//==============================================================================
+// One tan() per cut, however many sections: they share the frequency and differ only in damping.
+void SvfChain::retuneCut(Cut& cut, int numSamples)
+{
+    if (! cut.needsRetuning && ! cut.frequency.isSmoothing())
+        return;
+
+    const auto g = getG(cut.frequency.skip(numSamples));
+
+    for (int i = 0; i < cut.numSections; ++i)
+    {
+        auto& section = cut.sections[(size_t) i];
+        section.k = cut.dampings[(size_t) i];
+        tune(g, section.k, section.a1, section.a2, section.a3);
+    }
+
+    cut.needsRetuning = false;
+}
+
+void SvfChain::retunePeak(int numSamples)
+{
+    if (! peak.needsRetuning && ! peak.frequency.isSmoothing() && ! peak.amplitude.isSmoothing() && ! peak.quality.isSmoothing())
+        return;
+
+    const auto g = getG(peak.frequency.skip(numSamples));
+    const auto A = peak.amplitude.skip(numSamples);
+    const auto Q = peak.quality.skip(numSamples);
+
+    // The bell (RBJ's peaking EQ): H(s) = (s^2 + s * A / Q + 1) / (s^2 + s / (A * Q) + 1) = 1 + k * (A^2 - 1) * bandpass:
+    auto& section = peak.section;
+    section.k = 1 / (Q * A);
+    tune(g, section.k, section.a1, section.a2, section.a3);
+    peak.bandGain = section.k * (A * A - 1);
+
+    peak.needsRetuning = false;
+}
+
+void SvfChain::processCut(Cut& cut, bool isHighPass, int channel, float* samples, int numSamples)
+{
+    auto& channelState = cut.state[(size_t) channel];
+
+    // One section at a time over the sub-block, with its coefficients and state in registers:
+    for (int i = 0; i < cut.numSections; ++i)
+    {
+        const auto& section = cut.sections[(size_t) i];
+        const auto k = section.k, a1 = section.a1, a2 = section.a2, a3 = section.a3;
+        auto ic1eq = channelState[(size_t) i][0], ic2eq = channelState[(size_t) i][1];
+        float v1, v2;
+
+        if (isHighPass)
+        {
+            for (int n = 0; n < numSamples; ++n)
+            {
+                const auto x = samples[n];
+                tick(x, a1, a2, a3, ic1eq, ic2eq, v1, v2);
+                samples[n] = x - k * v1 - v2;
+            }
+        }
+        else
+        {
+            for (int n = 0; n < numSamples; ++n)
+            {
+                tick(samples[n], a1, a2, a3, ic1eq, ic2eq, v1, v2);
+                samples[n] = v2;
+            }
+        }
+
+        juce::dsp::util::snapToZero(ic1eq);
+        juce::dsp::util::snapToZero(ic2eq);
+
+        channelState[(size_t) i] = { ic1eq, ic2eq };
+    }
+}
+
+void SvfChain::processPeak(int channel, float* samples, int numSamples)
+{
+    const auto& section = peak.section;
+    const auto a1 = section.a1, a2 = section.a2, a3 = section.a3, bandGain = peak.bandGain;
+    auto& sectionState = peak.state[(size_t) channel];
+    auto ic1eq = sectionState[0], ic2eq = sectionState[1];
+    float v1, v2;
+
+    for (int n = 0; n < numSamples; ++n)
+    {
+        const auto x = samples[n];
+        tick(x, a1, a2, a3, ic1eq, ic2eq, v1, v2);
+        samples[n] = x + bandGain * v1;
+    }
+
+    juce::dsp::util::snapToZero(ic1eq);
+    juce::dsp::util::snapToZero(ic2eq);
+
+    sectionState = { ic1eq, ic2eq };
+}
+
+void SvfChain::process(const juce::dsp::ProcessContextReplacing<float>& context)
+{
+    auto& block = context.getOutputBlock();
+    const auto numSamples = (int) block.getNumSamples();
+    const auto channelsToProcess = juce::jmin(numChannels, (int) block.getNumChannels());
+
+    // Settled filters run the whole block in one go; gliding ones are retuned every retuneInterval samples:
+    for (int start = 0; start < numSamples;)
+    {
+        const auto subBlockSize = isGliding() ? juce::jmin(retuneInterval, numSamples - start) : numSamples - start;
+
+        retuneCut(lowCut, subBlockSize);
+        retuneCut(highCut, subBlockSize);
+        retunePeak(subBlockSize);
+
+        const bool peakIsActive = peak.isActive();
+
+        for (int channel = 0; channel < channelsToProcess; ++channel)
+        {
+            auto* samples = block.getChannelPointer((size_t) channel) + start;
+
+            if (! lowCut.bypassed)
+                processCut(lowCut, true, channel, samples, subBlockSize);
+
+            if (peakIsActive)
+                processPeak(channel, samples, subBlockSize);
+
+            if (! highCut.bypassed)
+                processCut(highCut, false, channel, samples, subBlockSize);
+        }
+
+        start += subBlockSize;
+    }
+}
@@ -0,0 +1,107 @@
+/*
+  ==============================================================================
+
+    SvfChain.h
+
+    The same low cut, peak and high cut as MonoChain (and the same
+    responses), built from topology-preserving transform (trapezoidal)
+    state variable filters instead of direct form biquads, for both
+    channels at once.
+
+    Retuning an SVF takes g = tan(pi * f / fs) and a few multiplies, and its
+    state stays meaningful when g changes, so the filters glide to new
+    settings a few samples at a time, without the transients of swapping
+    biquad coefficients under fast modulation.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <array>
+
+/**
+ Not thread-safe: call the setters from the thread that calls process() (at the start of a block, say),
+ as SimpleEQAudioProcessor does with its parameters. Nothing here allocates.
+ */
+class SvfChain
+{
+public:
+    static constexpr int maxChannels = 2;
+    static constexpr int maxCutSections = 4;
+
+    // While anything is gliding, the filters are retuned every this many samples:
+    static constexpr int retuneInterval = 8;
+    static constexpr double glideSeconds = 0.02;
+
+    void prepare(double sampleRate, int numChannels);
+
+    // Clears the filters' state:
+    void reset();
+
+    // Frequencies, gain and Q glide to the new settings; cut orders (2 to 8) and bypasses switch straight away:
+    void setLowCut(float frequency, int order, bool bypassed);
+    void setPeak(float frequency, float gainInDecibels, float quality, bool bypassed);
+    void setHighCut(float frequency, int order, bool bypassed);
+
+    // Jumps to the settings last set, without gliding:
+    void finishGlides();
+
+    bool isGliding() const;
+
+    // In place, on up to maxChannels channels (the number prepared):
+    void process(const juce::dsp::ProcessContextReplacing<float>& context);
+
+private:
+    using LogSmoothedValue = juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative>;
+
+    // Trapezoidal integrator SVF coefficients (k = 1 / Q), and its two integrators' state:
+    struct Section
+    {
+        float k = 2.f, a1 = 1.f, a2 = 0.f, a3 = 0.f;
+    };
+
+    using SectionState = std::array<float, 2>;
+
+    struct Cut
+    {
+        LogSmoothedValue frequency;
+        int numSections = 0;
+        bool bypassed = true, needsRetuning = true;
+
+        // 1 / Q of each Butterworth section:
+        std::array<float, maxCutSections> dampings {};
+        std::array<Section, maxCutSections> sections;
+        std::array<std::array<SectionState, maxCutSections>, maxChannels> state {};
+    };
+
+    struct Peak
+    {
+        // (the gain as a linear amplitude factor, A = 10^(dB / 40), so all three glide multiplicatively)
+        LogSmoothedValue frequency, amplitude, quality;
+        bool bypassed = true, needsRetuning = true;
+
+        Section section;
+        float bandGain = 0.f;   // k * (A^2 - 1)
+        std::array<SectionState, maxChannels> state {};
+
+        // A bypassed peak glides to 0 dB first, then stops running:
+        bool isActive() const { return ! bypassed || amplitude.isSmoothing() || amplitude.getCurrentValue() != 1.f; }
+    };
+
+    double sampleRate = 0.0;
+    int numChannels = 0;
+
+    Cut lowCut, highCut;
+    Peak peak;
+
+    void setCut(Cut& cut, float frequency, int order, bool bypassed);
+    void retuneCut(Cut& cut, int numSamples);
+    void retunePeak(int numSamples);
+    float getG(float frequency) const;
+
+    static void processCut(Cut& cut, bool isHighPass, int channel, float* samples, int numSamples);
+    void processPeak(int channel, float* samples, int numSamples);
+};